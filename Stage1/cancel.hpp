@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * Cooperative cancellation of a long computation.
+ * Whoever owns the request (the server's watcher thread) calls cancel();
+ * algorithms take a `const CancelToken*` (nullptr: never cancelled), poll it
+ * from their inner loops and return early with a partial result that the
+ * caller discards. Polling is one relaxed atomic load; loops that do very
+ * little per step go through CancelPoll to pay it only every few thousand
+ * steps.
+ */
+class CancelToken {
+public:
+    enum class Reason { None, Timeout, Disconnected };
+
+    // The first reason given wins; later calls change nothing.
+    void cancel(Reason why) noexcept {
+        int none = 0;
+        m_reason.compare_exchange_strong(none, static_cast<int>(why), std::memory_order_relaxed);
+    }
+
+    bool cancelled() const noexcept { return m_reason.load(std::memory_order_relaxed) != 0; }
+    Reason reason() const noexcept { return static_cast<Reason>(m_reason.load(std::memory_order_relaxed)); }
+
+private:
+    std::atomic<int> m_reason{0};
+};
+
+inline bool cancelled(const CancelToken* token) noexcept { return token && token->cancelled(); }
+
+// Checks a token every kStride calls: `CancelPoll poll(token); while (...) { if (poll()) return; ... }`.
+class CancelPoll {
+public:
+    static constexpr std::size_t kStride = 4096;
+
+    explicit CancelPoll(const CancelToken* token) noexcept : m_token(token) {}
+
+    bool operator()() noexcept { return m_token && ++m_count % kStride == 0 && m_token->cancelled(); }
+
+private:
+    const CancelToken* m_token;
+    std::size_t m_count = 0;
+};
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Buffered writer to a file descriptor with fast unsigned formatting.
+ * Large results (Euler circuits, component lists) are streamed through one
+ * reusable buffer instead of being built as strings first.
+ * For sockets, writes use send(MSG_NOSIGNAL) so a closed peer shows up as
+ * ok() == false instead of SIGPIPE.
+ * The string form appends to a caller's string instead (results that are
+ * kept, e.g. in the result cache), with the same formatting.
+ * tee() also copies what is written from then on into a string, up to a
+ * limit, so a streamed result can be kept without building it first.
+ */
+class FdWriter {
+public:
+    explicit FdWriter(int fd, bool socket = false, std::size_t capacity = 1 << 16)
+        : m_fd(fd), m_socket(socket), m_buf(capacity < 32 ? 32 : capacity) {}
+    explicit FdWriter(std::string& out, std::size_t capacity = 1 << 12)
+        : m_str(&out), m_buf(capacity < 32 ? 32 : capacity) {}
+    ~FdWriter() { flush(); }
+
+    FdWriter(const FdWriter&) = delete;
+    FdWriter& operator=(const FdWriter&) = delete;
+
+    void put(char c) {
+        if (m_len == m_buf.size()) flush();
+        m_buf[m_len++] = c;
+    }
+
+    void put(std::string_view s) {
+        if (s.size() > m_buf.size() - m_len) {
+            flush();
+            if (s.size() >= m_buf.size()) {
+                copy(s.data(), s.size());
+                write_all(s.data(), s.size());
+                return;
+            }
+        }
+        std::memcpy(m_buf.data() + m_len, s.data(), s.size());
+        m_len += s.size();
+    }
+
+    // Decimal, two digits per step from a lookup table.
+    void put_uint(std::uint64_t v) {
+        static constexpr char kPairs[] =
+            "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+            "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+        if (m_buf.size() - m_len < 20) flush();
+        char tmp[20];
+        char* p = tmp + sizeof(tmp);
+        while (v >= 100) {
+            const std::size_t i = static_cast<std::size_t>(v % 100) * 2;
+            v /= 100;
+            *--p = kPairs[i + 1];
+            *--p = kPairs[i];
+        }
+        if (v >= 10) {
+            const std::size_t i = static_cast<std::size_t>(v) * 2;
+            *--p = kPairs[i + 1];
+            *--p = kPairs[i];
+        } else {
+            *--p = static_cast<char>('0' + v);
+        }
+        const std::size_t len = static_cast<std::size_t>(tmp + sizeof(tmp) - p);
+        std::memcpy(m_buf.data() + m_len, p, len);
+        m_len += len;
+    }
+
+    void put_int(std::int64_t v) {
+        if (v < 0) put('-');
+        put_uint(v < 0 ? 0 - static_cast<std::uint64_t>(v) : static_cast<std::uint64_t>(v));
+    }
+
+    bool flush() {
+        if (m_len) {
+            copy(m_buf.data() + m_copy_from, m_len - m_copy_from);
+            write_all(m_buf.data(), m_len);
+        }
+        m_len = m_copy_from = 0;
+        return m_ok;
+    }
+
+    // Copy everything written from now on into 'to' as well, while it stays
+    // within 'limit' bytes; past that the copy is dropped and not resumed.
+    void tee(std::string& to, std::size_t limit) {
+        m_copy = &to;
+        m_copy_limit = limit;
+        m_copy_from = m_len;
+    }
+
+    // Stop copying; true if 'to' holds everything written since tee().
+    bool end_tee() {
+        copy(m_buf.data() + m_copy_from, m_len - m_copy_from);
+        const bool complete = m_copy != nullptr;
+        m_copy = nullptr;
+        m_copy_from = 0;
+        return complete;
+    }
+
+    // False once any write failed (e.g. the peer closed the connection).
+    bool ok() const noexcept { return m_ok; }
+
+private:
+    void copy(const char* p, std::size_t len) {
+        if (!m_copy) return;
+        if (len > m_copy_limit - m_copy->size()) {
+            std::string().swap(*m_copy);
+            m_copy = nullptr;
+            return;
+        }
+        m_copy->append(p, len);
+    }
+
+    void write_all(const char* p, std::size_t left) {
+        if (m_str) {
+            m_str->append(p, left);
+            return;
+        }
+        while (m_ok && left) {
+            ssize_t w = m_socket ? ::send(m_fd, p, left, MSG_NOSIGNAL) : ::write(m_fd, p, left);
+            if (w < 0 && errno == EINTR) continue;
+            if (w <= 0) { m_ok = false; break; }
+            p += w;
+            left -= static_cast<std::size_t>(w);
+        }
+    }
+
+    int m_fd{-1};
+    bool m_socket{false};
+    std::string* m_str{nullptr};
+    bool m_ok{true};
+    std::vector<char> m_buf;
+    std::size_t m_len{0};
+    std::string* m_copy{nullptr};
+    std::size_t m_copy_limit{0};
+    std::size_t m_copy_from{0}; // buffered bytes before tee() are not copied
+};
@@ -1,27 +1,75 @@
 #include "graph.hpp"
+#include "parallel.hpp"
 
 #include <algorithm>
 #include <cstdint>
-#include <cctype>
-#include <fstream>
-#include <optional>
-#include <queue>
-#include <random>
-#include <sstream>
+#include <limits>
 #include <stdexcept>
 #include <string>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
+namespace {
+
+void check_vertex_count(std::size_t n) {
+    if (n > 0 && n - 1 > static_cast<std::size_t>(std::numeric_limits<vertex_t>::max())) {
+        throw std::invalid_argument("too many vertices for 32-bit ids (rebuild with -DGRAPH_WIDE_IDS)");
+    }
+}
+
+// Edge ids are vertex_t as well, so at most max(vertex_t)+1 edges.
+constexpr std::size_t kMaxEdges = static_cast<std::size_t>(std::numeric_limits<vertex_t>::max());
+
+// LSD radix sort of 64-bit keys, one byte per pass. Passes above the highest
+// set bit of max_key are skipped, so keys < 2^40 take five passes.
+void radix_sort(std::vector<std::uint64_t>& keys, std::uint64_t max_key) {
+    std::vector<std::uint64_t> tmp(keys.size());
+    for (unsigned shift = 0; shift < 64 && (max_key >> shift) != 0; shift += 8) {
+        std::size_t count[257] = {};
+        for (std::uint64_t k : keys) ++count[((k >> shift) & 0xffU) + 1];
+        for (std::size_t i = 0; i < 256; ++i) count[i + 1] += count[i];
+        for (std::uint64_t k : keys) tmp[count[(k >> shift) & 0xffU]++] = k;
+        keys.swap(tmp);
+    }
+}
+
+// Owned storage behind a frozen graph built in memory.
+struct CsrArrays {
+    std::vector<std::size_t> offsets;
+    std::vector<vertex_t> nbrs;
+    std::vector<vertex_t> eids;
+};
+
+} // namespace
+
 // ---------- Construction ----------
 Graph::Graph(std::size_t n)
-    : m_n(n), m_m(0), adj(n) {}
+    : m_n(n), m_m(0) {
+    check_vertex_count(n);
+    adj.resize(n);
+    adj_ids.resize(n);
+}
+
+Graph::Graph(std::size_t n, std::size_t m, std::vector<std::size_t> offsets, std::vector<vertex_t> nbrs,
+             std::vector<vertex_t> eids)
+    : m_n(n), m_m(m), m_frozen(true) {
+    auto csr = std::make_shared<CsrArrays>(CsrArrays{std::move(offsets), std::move(nbrs), std::move(eids)});
+    m_offsets = csr->offsets.data();
+    m_nbrs = csr->nbrs.data();
+    m_eids = csr->eids.data();
+    m_csr = std::move(csr);
+}
+
+Graph::Graph(std::size_t n, std::size_t m, std::shared_ptr<const void> owner,
+             const std::size_t* offsets, const vertex_t* nbrs, const vertex_t* eids)
+    : m_n(n), m_m(m), m_frozen(true), m_csr(std::move(owner)), m_offsets(offsets), m_nbrs(nbrs), m_eids(eids) {}
 
 // ---------- Edge updates ----------
 bool Graph::add_edge(std::size_t u, std::size_t v) {
+    if (m_frozen) return false;             // immutable after finalize()
     if (u >= m_n || v >= m_n) return false; // out of range
     if (u == v) return false;               // no self-loops
+    if (m_m >= kMaxEdges) return false;     // edge ids exhausted
 
     // prevent multi-edges
     auto &lu = adj[u];
@@ -29,19 +77,54 @@ bool Graph::add_edge(std::size_t u, std::size_t v) {
         return false; // already exists
     }
 
-    adj[u].push_back(v);
-    adj[v].push_back(u);
+    adj[u].push_back(static_cast<vertex_t>(v));
+    adj[v].push_back(static_cast<vertex_t>(u));
+    adj_ids[u].push_back(static_cast<vertex_t>(m_m));
+    adj_ids[v].push_back(static_cast<vertex_t>(m_m));
     ++m_m;
     return true;
 }
 
+// ---------- Representation ----------
+void Graph::finalize() {
+    if (m_frozen) return;
+
+    std::vector<std::size_t> offsets(m_n + 1, 0);
+    for (std::size_t u = 0; u < m_n; ++u) {
+        offsets[u + 1] = offsets[u] + adj[u].size();
+    }
+
+    std::vector<vertex_t> nbrs(offsets[m_n]), eids(offsets[m_n]);
+    for (std::size_t u = 0; u < m_n; ++u) {
+        const auto at = static_cast<std::ptrdiff_t>(offsets[u]);
+        std::copy(adj[u].begin(), adj[u].end(), nbrs.begin() + at);
+        std::copy(adj_ids[u].begin(), adj_ids[u].end(), eids.begin() + at);
+    }
+
+    // Drop the per-vertex lists (swap forces the memory to be released)
+    std::vector<std::vector<vertex_t>>().swap(adj);
+    std::vector<std::vector<vertex_t>>().swap(adj_ids);
+    *this = Graph(m_n, m_m, std::move(offsets), std::move(nbrs), std::move(eids));
+}
+
+std::size_t Graph::memory_bytes() const {
+    if (m_frozen) {
+        return (m_n + 1) * sizeof(std::size_t) + 4 * m_m * sizeof(vertex_t) +
+               (m_weights ? m_m * sizeof(weight_t) : 0);
+    }
+    std::size_t bytes = 2 * adj.capacity() * sizeof(std::vector<vertex_t>);
+    for (const auto& lst : adj) bytes += lst.capacity() * sizeof(vertex_t);
+    for (const auto& lst : adj_ids) bytes += lst.capacity() * sizeof(vertex_t);
+    return bytes;
+}
+
 // ---------- Euler helpers ----------
 bool Graph::is_connected_ignoring_isolated() const {
     // Find a starting vertex with non-zero degree and count non-isolated vertices
     std::size_t start = m_n;
     std::size_t non_isolated = 0;
     for (std::size_t i = 0; i < m_n; ++i) {
-        if (!adj[i].empty()) {
+        if (degree(i) != 0) {
             ++non_isolated;
             if (start == m_n) start = i;
         }
@@ -50,23 +133,21 @@ bool Graph::is_connected_ignoring_isolated() const {
     // Trivial cases: no or one non-isolated vertex -> connected subgraph
     if (non_isolated <= 1) return true;
 
-    // BFS from the first non-isolated vertex
+    // BFS from the first non-isolated vertex. The visit order itself is the
+    // queue: every vertex is pushed at most once, so a flat vector suffices.
     std::vector<char> vis(m_n, 0);
-    std::queue<std::size_t> q;
+    std::vector<vertex_t> q;
+    q.reserve(non_isolated);
     vis[start] = 1;
-    q.push(start);
+    q.push_back(static_cast<vertex_t>(start));
     std::size_t reached = 1; // we've reached 'start' (which is non-isolated)
 
-    while (!q.empty()) {
-        auto u = q.front();
-        q.pop();
-        for (std::size_t v : adj[u]) {
+    for (std::size_t head = 0; head < q.size(); ++head) {
+        for (vertex_t v : neighbors(q[head])) {
             if (!vis[v]) {
                 vis[v] = 1;
-                q.push(v);
-                if (!adj[v].empty()) {
-                    ++reached; // count only non-isolated vertices
-                }
+                q.push_back(v);
+                ++reached; // a neighbor always has degree >= 1
             }
         }
     }
@@ -75,68 +156,239 @@ bool Graph::is_connected_ignoring_isolated() const {
 }
 
 bool Graph::all_even_degrees() const {
+    if (m_frozen) {
+        // deg(i) = off[i+1] - off[i] with off[0] = 0, so all degrees are even
+        // iff all offsets are; OR-reduce them in blocks (vectorizes).
+        constexpr std::size_t kBlock = 4096;
+        for (std::size_t b = 0; b <= m_n; b += kBlock) {
+            const std::size_t e = std::min(m_n + 1, b + kBlock);
+            std::size_t acc = 0;
+            for (std::size_t i = b; i < e; ++i) acc |= m_offsets[i];
+            if ((acc & 1U) != 0U) return false;
+        }
+        return true;
+    }
     for (std::size_t i = 0; i < m_n; ++i) {
-        if ((adj[i].size() & 1U) != 0U) return false;
+        if ((degree(i) & 1U) != 0U) return false;
     }
     return true;
 }
 
-// ---------- I/O & generators ----------
-std::optional<Graph> Graph::load_from_file(const std::string& path) {
-    std::ifstream in(path);
-    if (!in) return std::nullopt;
+// ---------- Bulk builder ----------
+GraphBuilder::GraphBuilder(std::size_t n)
+    : m_n(n) {
+    check_vertex_count(n);
+}
 
-    std::string line;
+bool GraphBuilder::add_edge(std::size_t u, std::size_t v) {
+    if (!record(u, v)) return false;
+    if (!m_weights.empty()) m_weights.push_back(1);
+    return true;
+}
 
-    // Read first non-empty, non-comment line as "n m"
-    std::size_t n = 0, m = 0;
-    while (std::getline(in, line)) {
-        // skip blanks and comments
-        bool only_ws = true;
-        for (char c : line) {
-            if (!std::isspace(static_cast<unsigned char>(c))) { only_ws = false; break; }
-        }
-        if (only_ws || (!line.empty() && line[0] == '#')) continue;
+bool GraphBuilder::add_edge(std::size_t u, std::size_t v, weight_t w) {
+    if (!record(u, v)) return false;
+    if (m_weights.empty()) {
+        m_weights.reserve(m_edges.capacity());
+        m_weights.assign(m_edges.size() - 1, 1);
+    }
+    m_weights.push_back(w);
+    return true;
+}
 
-        std::istringstream hdr(line);
-        if (!(hdr >> n >> m)) return std::nullopt;
-        break;
+bool GraphBuilder::record(std::size_t u, std::size_t v) {
+    if (m_error) return false;
+    if (u >= m_n || v >= m_n) {
+        m_error = Error{m_edges.size(), "vertex id out of range"};
+        return false;
+    }
+    if (u == v) {
+        m_error = Error{m_edges.size(), "self-loop"};
+        return false;
     }
+    if (m_edges.size() >= kMaxEdges) {
+        m_error = Error{m_edges.size(), "too many edges for 32-bit ids"};
+        return false;
+    }
+    m_edges.push_back({static_cast<vertex_t>(u), static_cast<vertex_t>(v)});
+    return true;
+}
 
-    // Basic validation with 64-bit arithmetic
-    const std::uint64_t nn = static_cast<std::uint64_t>(n);
-    const std::uint64_t max_m = (nn * (nn - 1)) / 2ull;
-    if (n == 0) {
-        if (m != 0) return std::nullopt;
-    } else {
-        if (static_cast<std::uint64_t>(m) > max_m) return std::nullopt;
+bool GraphBuilder::find_duplicate() {
+    const std::size_t m = m_edges.size();
+    if (m < 2) return false;
+
+    auto key_of = [this](const Edge& e) {
+        vertex_t a = e.u, b = e.v;
+        if (b < a) std::swap(a, b);
+#ifdef GRAPH_WIDE_IDS
+        return std::make_pair(a, b);
+#else
+        return static_cast<std::uint64_t>(a) * m_n + b;
+#endif
+    };
+
+    // Sort canonical keys; equal neighbors are duplicates.
+    std::vector<decltype(key_of(m_edges[0]))> keys(m);
+    for (std::size_t i = 0; i < m; ++i) keys[i] = key_of(m_edges[i]);
+#ifdef GRAPH_WIDE_IDS
+    std::sort(keys.begin(), keys.end());
+#else
+    radix_sort(keys, static_cast<std::uint64_t>(m_n) * m_n - 1);
+#endif
+
+    std::vector<decltype(key_of(m_edges[0]))> dups;
+    for (std::size_t i = 1; i < m; ++i) {
+        if (keys[i] == keys[i - 1] && (dups.empty() || dups.back() != keys[i])) dups.push_back(keys[i]);
     }
+    if (dups.empty()) return false;
+
+    // Error path: replay in insertion order to name the first edge that
+    // Graph::add_edge would have rejected. Only duplicated keys are tracked.
+    std::vector<char> seen(dups.size(), 0);
+    for (std::size_t i = 0; i < m; ++i) {
+        auto it = std::lower_bound(dups.begin(), dups.end(), key_of(m_edges[i]));
+        if (it == dups.end() || *it != key_of(m_edges[i])) continue;
+        char& s = seen[static_cast<std::size_t>(it - dups.begin())];
+        if (s) {
+            m_error = Error{i, "duplicate edge"};
+            return true;
+        }
+        s = 1;
+    }
+    return false; // unreachable: a duplicated key occurs twice
+}
 
-    Graph g(n);
+std::optional<Graph> GraphBuilder::build() {
+    if (m_error || find_duplicate()) return std::nullopt;
+    return build_csr();
+}
 
-    // Read exactly m edge lines (u v). Allow skipping blank/comment lines.
-    std::size_t added = 0;
-    while (added < m && std::getline(in, line)) {
-        // skip blanks and comments
-        bool only_ws = true;
-        for (char c : line) {
-            if (!std::isspace(static_cast<unsigned char>(c))) { only_ws = false; break; }
-        }
-        if (only_ws || (!line.empty() && line[0] == '#')) continue;
+Graph GraphBuilder::build_csr() {
+    const std::size_t m = m_edges.size();
 
-        std::istringstream es(line);
-        std::size_t u, v;
-        if (!(es >> u >> v)) return std::nullopt;
-        if (!g.add_edge(u, v)) return std::nullopt; // invalid id, self-loop, or duplicate
-        ++added;
+    // Degree count -> prefix sums -> scatter, all in insertion order
+    std::vector<std::size_t> offsets(m_n + 1, 0);
+    for (const Edge& e : m_edges) {
+        ++offsets[e.u + 1];
+        ++offsets[e.v + 1];
+    }
+    for (std::size_t i = 0; i < m_n; ++i) offsets[i + 1] += offsets[i];
+
+    std::vector<vertex_t> nbrs(2 * m), eids(2 * m);
+    std::vector<std::size_t> pos(offsets.begin(), offsets.end() - 1);
+    for (std::size_t i = 0; i < m; ++i) {
+        const Edge& e = m_edges[i];
+        eids[pos[e.u]] = static_cast<vertex_t>(i);
+        nbrs[pos[e.u]++] = e.v;
+        eids[pos[e.v]] = static_cast<vertex_t>(i);
+        nbrs[pos[e.v]++] = e.u;
     }
 
-    if (added != m) return std::nullopt; // file ended early
-
+    std::vector<Edge>().swap(m_edges);
+    Graph g(m_n, m, std::move(offsets), std::move(nbrs), std::move(eids));
+    if (!m_weights.empty()) g = g.with_weights(std::move(m_weights));
+    m_weights.clear();
     return g;
 }
 
-Graph Graph::random_simple(std::size_t n, std::size_t m, unsigned seed) {
+// ---------- Generators ----------
+// (file I/O lives in graph_io.cpp)
+//
+// random_simple draws candidate edges from a counter-based RNG: candidate i
+// is a pure function of (seed, i), so any thread can produce any candidate.
+// The graph is the first m distinct pairs of that sequence. Candidates are
+// made in parallel, deduplicated by sorting (u<v) keys in key-range buckets,
+// and topped up in further rounds until m distinct pairs exist. The result
+// depends only on the seed, never on the thread count. Memory is O(m).
+namespace {
+
+std::uint64_t mix64(std::uint64_t z) { // splitmix64 finalizer
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+struct Candidate {
+    std::uint64_t key; // a*n + b with a < b
+    std::uint64_t idx; // position in the candidate sequence
+};
+
+// Flags (indexed by Candidate::idx < idx_bound) every candidate whose key
+// already occurred at a smaller idx. Keys are bucketed by range (they are
+// close to uniform) and the buckets sorted in parallel.
+std::vector<char> repeated_keys(const std::vector<Candidate>& cand, std::uint64_t max_key,
+                                std::uint64_t idx_bound, unsigned threads) {
+    const std::size_t total = cand.size();
+    const std::size_t buckets = std::max<std::size_t>(1, total / 64);
+    const std::uint64_t width = max_key / buckets + 1;
+    std::vector<std::size_t> start(buckets + 1, 0);
+    for (const Candidate& c : cand) ++start[c.key / width + 1];
+    for (std::size_t b = 0; b < buckets; ++b) start[b + 1] += start[b];
+    std::vector<Candidate> sorted(total);
+    {
+        std::vector<std::size_t> pos(start.begin(), start.end() - 1);
+        for (const Candidate& c : cand) sorted[pos[c.key / width]++] = c;
+    }
+
+    // In each run of equal keys only the earliest candidate is not a repeat
+    std::vector<char> dup(idx_bound, 0);
+    parallel_for(buckets, threads, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t b = lo; b < hi; ++b) {
+            auto first = sorted.begin() + static_cast<std::ptrdiff_t>(start[b]);
+            auto last = sorted.begin() + static_cast<std::ptrdiff_t>(start[b + 1]);
+            std::sort(first, last, [](const Candidate& x, const Candidate& y) {
+                return x.key != y.key ? x.key < y.key : x.idx < y.idx;
+            });
+            for (auto it = first; it != last; ++it)
+                if (it != first && it->key == (it - 1)->key) dup[it->idx] = 1;
+        }
+    }, 256);
+    return dup;
+}
+
+// Keys of the first 'count' distinct pairs, in sequence order.
+std::vector<std::uint64_t> sample_pairs(std::size_t n, std::size_t count, unsigned seed, unsigned threads) {
+    const std::uint64_t nn = n;
+    const std::uint64_t base = mix64(seed + 0x9e3779b97f4a7c15ULL);
+    const std::uint64_t max_key = (nn - 1) * nn + (nn - 1);
+
+    std::vector<Candidate> cand; // survivors so far, in idx order
+    std::uint64_t next = 0;      // candidates drawn so far
+    while (cand.size() < count) {
+        // Draw the shortfall plus ~1/8 slack for collisions
+        const std::size_t need = count - cand.size();
+        const std::size_t extra = need + need / 8 + 64;
+        const std::size_t old = cand.size();
+        cand.resize(old + extra);
+        parallel_for(extra, threads, [&](std::size_t lo, std::size_t hi) {
+            for (std::size_t i = lo; i < hi; ++i) {
+                const std::uint64_t idx = next + i;
+                const std::uint64_t h = base + 2 * idx * 0x9e3779b97f4a7c15ULL;
+                std::uint64_t a = mix64(h) % nn;
+                std::uint64_t b = mix64(h + 0x9e3779b97f4a7c15ULL) % (nn - 1);
+                if (b >= a) ++b;                 // uniform over b != a
+                if (b < a) std::swap(a, b);
+                cand[old + i] = {a * nn + b, idx};
+            }
+        }, 1u << 14);
+        next += extra;
+
+        const std::vector<char> dup = repeated_keys(cand, max_key, next, threads);
+        std::size_t kept = 0;
+        for (const Candidate& c : cand)
+            if (!dup[c.idx]) cand[kept++] = c;
+        cand.resize(std::min(kept, count));
+    }
+
+    std::vector<std::uint64_t> keys(count);
+    for (std::size_t i = 0; i < count; ++i) keys[i] = cand[i].key;
+    return keys;
+}
+
+} // namespace
+
+Graph Graph::random_simple(std::size_t n, std::size_t m, unsigned seed, unsigned threads) {
     // Validate parameters
     const std::uint64_t nn = static_cast<std::uint64_t>(n);
     const std::uint64_t max_m = (nn * (nn - 1)) / 2ull;
@@ -146,57 +398,131 @@ Graph Graph::random_simple(std::size_t n, std::size_t m, unsigned seed) {
     if (n == 0 && m != 0) {
         throw std::invalid_argument("cannot place edges on an empty graph");
     }
+    if (nn > (std::uint64_t{1} << 32)) {
+        throw std::invalid_argument("too many vertices for random_simple (pair keys must fit in 64 bits)");
+    }
 
-    Graph g(n);
-    if (m == 0 || n <= 1) return g;
-
-    std::mt19937 rng(seed);
+    GraphBuilder builder(n);
+    if (m == 0 || n <= 1) return *builder.build();
+    builder.reserve(m);
 
-    // Hybrid strategy:
-    //  - Sparse case (m <= max_m/2): rejection with a hash set of unique (u<v) pairs.
-    //  - Dense case  (m >  max_m/2): generate all pairs (u<v), shuffle, take first m.
     if (static_cast<std::uint64_t>(m) <= max_m / 2ull) {
-        // --- Sparse: rejection sampling with uniqueness set ---
-        std::uniform_int_distribution<std::size_t> dist(0, n - 1);
-
-        std::unordered_set<std::uint64_t> seen;
-        seen.reserve(m * 2 + 16);
-
-        auto pack = [](std::size_t a, std::size_t b) -> std::uint64_t {
-            if (b < a) std::swap(a, b); // canonical u<v
-            return (static_cast<std::uint64_t>(a) << 32) | static_cast<std::uint64_t>(b);
-        };
-
-        while (seen.size() < m) {
-            std::size_t u = dist(rng);
-            std::size_t v = dist(rng);
-            if (u == v) continue; // no self-loops
-            (void)seen.insert(pack(u, v));
-        }
-
-        for (auto key : seen) {
-            std::size_t u = static_cast<std::size_t>(key >> 32);
-            std::size_t v = static_cast<std::size_t>(key & 0xffffffffULL);
-            g.add_edge(u, v); // guaranteed valid & unique
-        }
+        // Sparse: the first m distinct pairs, in sequence order
+        for (std::uint64_t key : sample_pairs(n, m, seed, threads))
+            builder.add_edge(static_cast<std::size_t>(key / nn), static_cast<std::size_t>(key % nn));
     } else {
-        // --- Dense: generate all pairs and shuffle ---
-        std::vector<std::pair<std::size_t, std::size_t>> edges;
-        edges.reserve(static_cast<std::size_t>(max_m));
-
+        // Dense: sample the max_m - m missing pairs, emit all others
+        std::vector<std::uint64_t> missing =
+            sample_pairs(n, static_cast<std::size_t>(max_m - m), seed, threads);
+        radix_sort(missing, (nn - 1) * nn + (nn - 1));
+        auto skip = missing.begin();
         for (std::size_t u = 0; u < n; ++u) {
             for (std::size_t v = u + 1; v < n; ++v) {
-                edges.emplace_back(u, v);
+                const std::uint64_t key = u * nn + v;
+                if (skip != missing.end() && *skip == key) { ++skip; continue; }
+                builder.add_edge(u, v); // cannot fail: in-range & unique
             }
         }
+    }
 
-        std::shuffle(edges.begin(), edges.end(), rng);
+    return builder.build_csr(); // pairs are distinct by construction
+}
 
-        for (std::size_t i = 0; i < m; ++i) {
-            auto [u, v] = edges[i];
-            g.add_edge(u, v); // cannot fail: in-range & unique
+Graph Graph::random_eulerian(std::size_t n, std::size_t m, unsigned seed, unsigned threads) {
+    const std::uint64_t nn = static_cast<std::uint64_t>(n);
+    if (m > (nn * (nn - 1)) / 2ull) {
+        throw std::invalid_argument("m exceeds the maximum number of edges for a simple undirected graph");
+    }
+    if (nn > (std::uint64_t{1} << 32)) {
+        throw std::invalid_argument("too many vertices for random_eulerian (pair keys must fit in 64 bits)");
+    }
+
+    GraphBuilder builder(n);
+    if (m < 3 || n < 3) return *builder.build(); // no simple cycle fits
+
+    std::uint64_t state = mix64(seed + 0x2545f4914f6cdd1dULL);
+    auto next = [&state] { return mix64(state += 0x9e3779b97f4a7c15ULL); };
+    auto key = [nn](std::size_t a, std::size_t b) {
+        if (b < a) std::swap(a, b);
+        return a * nn + b;
+    };
+
+    std::vector<Candidate> edges;     // kept cycles back to back; idx == position
+    std::vector<std::size_t> cyc_end; // end of each cycle in 'edges'
+    edges.reserve(m);
+    auto push_cycle = [&](const std::vector<std::size_t>& cyc) {
+        for (std::size_t i = 0; i < cyc.size(); ++i)
+            edges.push_back({key(cyc[i], cyc[(i + 1) % cyc.size()]), edges.size()});
+        cyc_end.push_back(edges.size());
+    };
+
+    // Backbone: one cycle through a random order of min(n, m) vertices, so
+    // every non-isolated vertex ends up connected
+    std::vector<std::size_t> perm(n);
+    for (std::size_t i = 0; i < n; ++i) perm[i] = i;
+    for (std::size_t i = n - 1; i > 0; --i) std::swap(perm[i], perm[next() % (i + 1)]);
+    perm.resize(std::min(n, m));
+    push_cycle(perm);
+
+    // Rounds: append random cycles of length 3..8 over backbone vertices up
+    // to m edges, then drop every cycle that repeats an earlier edge (found
+    // by sorting keys, as in random_simple). Whole cycles keep all degrees
+    // even. Sparse requests finish in a round or two; dense ones stop after
+    // 64 rounds with whatever fits.
+    const std::size_t k = perm.size();
+    const std::uint64_t max_key = (nn - 1) * nn + (nn - 1);
+    std::vector<std::size_t> cyc;
+    for (unsigned round = 0; edges.size() + 3 <= m && round < 64; ++round) {
+        while (edges.size() + 3 <= m) {
+            cyc.resize(std::min<std::size_t>({3 + next() % 6, m - edges.size(), k}));
+            for (auto& v : cyc) v = perm[next() % k];
+            bool distinct = true;
+            for (std::size_t i = 0; i < cyc.size() && distinct; ++i)
+                for (std::size_t j = 0; j < i && distinct; ++j) distinct = cyc[i] != cyc[j];
+            if (distinct) push_cycle(cyc);
         }
+
+        const std::vector<char> dup = repeated_keys(edges, max_key, edges.size(), threads);
+        std::size_t out = 0, cycles = 0;
+        for (std::size_t c = 0, begin = 0; c < cyc_end.size(); begin = cyc_end[c++]) {
+            bool clean = true;
+            for (std::size_t i = begin; i < cyc_end[c] && clean; ++i) clean = !dup[i];
+            if (!clean) continue;
+            for (std::size_t i = begin; i < cyc_end[c]; ++i) edges[out++] = {edges[i].key, out};
+            cyc_end[cycles++] = out;
+        }
+        edges.resize(out);
+        cyc_end.resize(cycles);
     }
 
+    builder.reserve(edges.size());
+    for (const Candidate& e : edges)
+        builder.add_edge(static_cast<std::size_t>(e.key / nn), static_cast<std::size_t>(e.key % nn));
+    return builder.build_csr(); // only first occurrences were kept
+}
+
+// ---------- Weights ----------
+Graph Graph::with_weights(std::vector<weight_t> weights) const {
+    if (weights.size() != m_m) throw std::invalid_argument("need one weight per edge");
+    Graph g(*this);
+    g.finalize();
+    auto owned = std::make_shared<const std::vector<weight_t>>(std::move(weights));
+    g.m_weights = owned->data();
+    g.m_weight_owner = std::move(owned);
     return g;
 }
+
+std::vector<weight_t> Graph::random_weights(std::size_t m, weight_t lo, weight_t hi, unsigned seed,
+                                            unsigned threads) {
+    if (lo > hi) throw std::invalid_argument("empty weight range");
+    const std::uint64_t span = static_cast<std::uint64_t>(hi) - static_cast<std::uint64_t>(lo) + 1; // 0: full range
+    const std::uint64_t base = mix64(seed + 0x6a09e667f3bcc909ULL);
+    std::vector<weight_t> w(m);
+    parallel_for(m, threads, [&](std::size_t b, std::size_t e) {
+        for (std::size_t i = b; i < e; ++i) {
+            const std::uint64_t r = mix64(base + i * 0x9e3779b97f4a7c15ULL);
+            w[i] = static_cast<weight_t>(static_cast<std::uint64_t>(lo) + (span ? r % span : r));
+        }
+    }, 1u << 16);
+    return w;
+}
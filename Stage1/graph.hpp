@@ -4,37 +4,154 @@
 #include <string>
 #include <optional>
 #include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * Vertex id type used inside adjacency storage (edge ids use it too).
+ * 32-bit by default (half the footprint of size_t ids); build with
+ * -DGRAPH_WIDE_IDS for graphs with 2^32 or more vertices or edges.
+ */
+#ifdef GRAPH_WIDE_IDS
+using vertex_t = std::uint64_t;
+#else
+using vertex_t = std::uint32_t;
+#endif
+
+// Edge weight / capacity (1 for every edge of an unweighted graph).
+using weight_t = std::int64_t;
+
+/**
+ * Read-only view over a contiguous array (C++17 stand-in for std::span).
+ */
+template <typename T>
+class Span {
+public:
+    constexpr Span() noexcept = default;
+    constexpr Span(const T* data, std::size_t size) noexcept : m_data(data), m_size(size) {}
+
+    const T* begin() const noexcept { return m_data; }
+    const T* end() const noexcept { return m_data + m_size; }
+    const T* data() const noexcept { return m_data; }
+    std::size_t size() const noexcept { return m_size; }
+    bool empty() const noexcept { return m_size == 0; }
+
+    const T& operator[](std::size_t i) const { return m_data[i]; }
+    const T& front() const { return m_data[0]; }
+    const T& back() const { return m_data[m_size - 1]; }
+
+private:
+    const T* m_data{nullptr};
+    std::size_t m_size{0};
+};
 
 /**
  * Simple undirected graph with 0-based vertex IDs.
  * Constraints:
  *  - No self-loops
  *  - No parallel edges
+ * Edge ids:
+ *  - Every undirected edge gets the id 0..m-1 in insertion order. Both
+ *    directions carry the same id: edge_ids(u)[i] is the id of the edge
+ *    u -- neighbors(u)[i]. Algorithms use it to keep per-edge state.
+ * Weights:
+ *  - Optional, one weight_t per edge id (set through GraphBuilder, an
+ *    edge file's third column or with_weights()). Weighted graphs are always
+ *    frozen. An unweighted graph reports weight 1 for every edge.
  * Storage:
- *  - Adjacency lists in 'adj'
+ *  - While building: one adjacency list (plus edge-id list) per vertex
+ *  - After finalize(): frozen CSR form, i.e. one offsets array (n+1 entries)
+ *    plus contiguous neighbor and edge-id arrays (2m entries each). The graph is immutable
+ *    from then on; add_edge() returns false. The arrays are either owned
+ *    vectors or a read-only mapping of a binary graph file, and copies of a
+ *    frozen graph share them.
+ *
+ * neighbors(u) returns a Span in both modes, so consumers do not care which
+ * representation is active. load_from_file() and random_simple() return
+ * graphs that are already finalized. For bulk construction prefer
+ * GraphBuilder, which goes straight to CSR without per-vertex lists.
  *
  * Implemented in graph.cpp:
  *  - Graph(std::size_t n)
  *  - bool add_edge(std::size_t u, std::size_t v)
- *  - static std::optional<Graph> load_from_file(const std::string& path)
- *  - static Graph random_simple(std::size_t n, std::size_t m, unsigned seed)
+ *  - void finalize()
+ *  - std::size_t memory_bytes() const
+ *  - static Graph random_simple(std::size_t n, std::size_t m, unsigned seed, unsigned threads)
+ *  - static Graph random_eulerian(std::size_t n, std::size_t m, unsigned seed, unsigned threads)
  *  - bool is_connected_ignoring_isolated() const
  *  - bool all_even_degrees() const
+ *  - Graph with_weights(std::vector<weight_t> weights) const
+ *  - static std::vector<weight_t> random_weights(std::size_t m, weight_t lo, weight_t hi, unsigned seed, unsigned threads)
+ *  - GraphBuilder (below)
+ * Implemented in graph_io.cpp:
+ *  - static std::optional<Graph> load_from_file(const std::string& path, std::string* error, unsigned threads)
+ *  - static std::optional<Graph> load_binary(const std::string& path, std::string* error, bool verify)
+ *  - bool save_binary(const std::string& path, std::string* error) const
  */
 class Graph {
 public:
     // ---- Construction ----
+    // Throws std::invalid_argument if n does not fit in vertex_t.
     explicit Graph(std::size_t n);
 
     // ---- Basic queries (inline) ----
     std::size_t n() const noexcept { return m_n; }
     std::size_t m() const noexcept { return m_m; }
-    const std::vector<std::size_t>& neighbors(std::size_t u) const { return adj[u]; }
+    bool frozen() const noexcept { return m_frozen; }
+
+    Span<vertex_t> neighbors(std::size_t u) const {
+        if (m_frozen) return {m_nbrs + m_offsets[u], m_offsets[u + 1] - m_offsets[u]};
+        return {adj[u].data(), adj[u].size()};
+    }
+    Span<vertex_t> edge_ids(std::size_t u) const {
+        if (m_frozen) return {m_eids + m_offsets[u], m_offsets[u + 1] - m_offsets[u]};
+        return {adj_ids[u].data(), adj_ids[u].size()};
+    }
+    std::size_t degree(std::size_t u) const {
+        return m_frozen ? m_offsets[u + 1] - m_offsets[u] : adj[u].size();
+    }
+
+    // Edge weights (MST) / capacities (MAXFLOW), indexed by edge id.
+    bool weighted() const noexcept { return m_weights != nullptr; }
+    weight_t weight(std::size_t eid) const { return m_weights ? m_weights[eid] : 1; }
+    // All m weights by edge id (empty for an unweighted graph).
+    Span<weight_t> weights() const noexcept { return m_weights ? Span<weight_t>{m_weights, m_m} : Span<weight_t>{}; }
+
+    // Frozen copy sharing this graph's CSR arrays (an unfrozen graph is
+    // finalized first) in which edge e weighs weights[e]. Throws
+    // std::invalid_argument unless weights.size() == m().
+    Graph with_weights(std::vector<weight_t> weights) const;
+
+    // m weights drawn uniformly from [lo, hi]; weight e depends only on
+    // (seed, e), like random_simple's edges. Requires lo <= hi.
+    static std::vector<weight_t> random_weights(std::size_t m, weight_t lo, weight_t hi, unsigned seed,
+                                                unsigned threads = 1);
+
+    // Raw CSR arrays of a frozen graph (empty before finalize()). Slot p of
+    // csr_neighbors()/csr_edge_ids() belongs to the vertex u with
+    // csr_offsets()[u] <= p < csr_offsets()[u+1].
+    Span<std::size_t> csr_offsets() const noexcept {
+        return m_frozen ? Span<std::size_t>{m_offsets, m_n + 1} : Span<std::size_t>{};
+    }
+    Span<vertex_t> csr_neighbors() const noexcept {
+        return m_frozen ? Span<vertex_t>{m_nbrs, 2 * m_m} : Span<vertex_t>{};
+    }
+    Span<vertex_t> csr_edge_ids() const noexcept {
+        return m_frozen ? Span<vertex_t>{m_eids, 2 * m_m} : Span<vertex_t>{};
+    }
 
     // ---- Edge updates ----
-    // Returns true if a new edge was added; false if invalid or already exists.
+    // Returns true if a new edge was added; false if invalid, already exists,
+    // or the graph has been finalized.
     bool add_edge(std::size_t u, std::size_t v);
 
+    // Convert to the frozen CSR representation and release the per-vertex
+    // lists. Neighbor order is preserved. Calling it twice is a no-op.
+    void finalize();
+
+    // Approximate heap footprint of the adjacency storage, in bytes.
+    std::size_t memory_bytes() const;
+
     // ---- Euler helpers ----
     // True if the subgraph induced by non-isolated vertices is connected.
     bool is_connected_ignoring_isolated() const;
@@ -43,18 +160,133 @@ public:
     bool all_even_degrees() const;
 
     // ---- I/O & generators ----
-    // Load graph from file: first line "n m", then m lines "u v".
-    // On parse/validation error, returns std::nullopt.
-    static std::optional<Graph> load_from_file(const std::string& path);
+    // Load graph from file: first line "n m", then m lines "u v" or "u v w"
+    // (w: non-negative weight; the graph is weighted if any line has one and
+    // other edges weigh 1). A third field that is not a whole non-negative
+    // number but starts with a sign or digit ("-3", "3x") is an error; one
+    // starting with any other character is ignored.
+    // Blank lines and lines starting with '#' are skipped.
+    // On parse/validation error, returns std::nullopt and, if 'error' is
+    // given, stores a message naming the offending line.
+    // The file is mmap'ed and scanned in place; with threads > 1 the edge
+    // section is split into chunks that are parsed concurrently.
+    static std::optional<Graph> load_from_file(const std::string& path, std::string* error = nullptr,
+                                               unsigned threads = 1);
 
-    // Generate a random simple undirected graph with exactly m edges.
+    // Binary graph file (little-endian, 8-byte aligned sections):
+    //   header (64 bytes)
+    //     char magic[8] "EULGRAPH", u32 version, u32 id_bytes (sizeof(vertex_t)),
+    //     u64 n, u64 m, u64 payload_checksum, u64 header_checksum, u64 flags,
+    //     u64 reserved
+    //   u64      offsets[n+1]
+    //   vertex_t neighbors[2m]
+    //   vertex_t edge_ids[2m]
+    //   weight_t weights[m]     only if flags bit 0 is set (weighted graph)
+    // load_binary maps the file and uses the arrays in place: no parsing and
+    // no per-vertex allocation. The header and the array structure (offsets
+    // non-decreasing, every neighbor id < n and edge id < m) are always
+    // validated, one O(n + m) pass; 'verify' additionally checks the payload
+    // checksum. Beyond that the file must be trusted: an edited file that
+    // passes both, e.g. with edge ids that do not pair up the two directions
+    // of an edge, loads and gives wrong answers.
+    static std::optional<Graph> load_binary(const std::string& path, std::string* error = nullptr,
+                                            bool verify = false);
+
+    // Write a finalized graph in the binary format. Returns false on error.
+    bool save_binary(const std::string& path, std::string* error = nullptr) const;
+
+    // Generate a random simple undirected graph with exactly m edges, using
+    // 'threads' workers. The graph depends only on (n, m, seed), not on the
+    // thread count. Memory is O(m) even for dense graphs.
     // Throws std::invalid_argument if m > n*(n-1)/2 or parameters invalid.
-    static Graph random_simple(std::size_t n, std::size_t m, unsigned seed);
+    static Graph random_simple(std::size_t n, std::size_t m, unsigned seed, unsigned threads = 1);
+
+    // Generate a random connected graph in which every degree is even (so an
+    // Euler circuit exists): a cycle through min(n, m) random vertices plus
+    // random edge-disjoint cycles of length 3..8, for m - 2..m edges in total.
+    // Very dense requests stop early once cycles no longer fit. O(n + m)
+    // memory; 'threads' only speeds up duplicate detection, the graph depends
+    // on (n, m, seed) alone. Returns an edgeless graph if n < 3 or m < 3.
+    // Throws std::invalid_argument if m > n*(n-1)/2.
+    static Graph random_eulerian(std::size_t n, std::size_t m, unsigned seed, unsigned threads = 1);
 
     std::size_t num_vertices() const noexcept { return m_n; }
 
 private:
+    friend class GraphBuilder;
+
+    // Adopt ready-made CSR arrays (used by GraphBuilder).
+    Graph(std::size_t n, std::size_t m, std::vector<std::size_t> offsets, std::vector<vertex_t> nbrs,
+          std::vector<vertex_t> eids);
+
+    // Frozen graph over arrays kept alive by 'owner' (e.g. a file mapping).
+    Graph(std::size_t n, std::size_t m, std::shared_ptr<const void> owner,
+          const std::size_t* offsets, const vertex_t* nbrs, const vertex_t* eids);
+
     std::size_t m_n{0};
     std::size_t m_m{0};
-    std::vector<std::vector<std::size_t>> adj;
+    bool m_frozen{false};
+
+    // Build mode
+    std::vector<std::vector<vertex_t>> adj;
+    std::vector<std::vector<vertex_t>> adj_ids; // edge ids, parallel to adj
+
+    // Frozen (CSR) mode
+    std::shared_ptr<const void> m_csr;      // keeps the two arrays below alive
+    const std::size_t* m_offsets{nullptr};  // n+1 entries, m_offsets[n] == 2m
+    const vertex_t* m_nbrs{nullptr};        // neighbors of u: [m_offsets[u], m_offsets[u+1])
+    const vertex_t* m_eids{nullptr};        // edge ids, parallel to m_nbrs
+    std::shared_ptr<const void> m_weight_owner;  // keeps m_weights alive
+    const weight_t* m_weights{nullptr};           // by edge id; null if unweighted
+};
+
+/**
+ * Bulk construction of a finalized Graph.
+ *
+ * add_edge() only records the edge (O(1)); out-of-range ids and self-loops
+ * are rejected immediately. build() detects duplicates by radix-sorting
+ * packed (min,max) keys and then fills the CSR arrays in a single pass, so
+ * building m edges costs O(m) instead of O(m * deg) with Graph::add_edge.
+ * Neighbor order and edge ids match the order edges were added.
+ */
+class GraphBuilder {
+public:
+    struct Error {
+        std::size_t edge_index; // 0-based position of the offending add_edge() call
+        std::string what;       // "vertex id out of range", "self-loop", "duplicate edge", ...
+    };
+
+    // Throws std::invalid_argument if n does not fit in vertex_t.
+    explicit GraphBuilder(std::size_t n);
+
+    void reserve(std::size_t m) { m_edges.reserve(m); }
+    std::size_t size() const noexcept { return m_edges.size(); }
+
+    // Record edge u-v. Returns false (and sets error()) on an invalid edge;
+    // nothing more is recorded after the first error.
+    bool add_edge(std::size_t u, std::size_t v);
+
+    // Same with a weight; the built graph is then weighted and edges added
+    // without one weigh 1.
+    bool add_edge(std::size_t u, std::size_t v, weight_t w);
+
+    // Validate and build. Returns std::nullopt on the first duplicate edge
+    // (in insertion order) or if add_edge() already failed.
+    std::optional<Graph> build();
+
+    const std::optional<Error>& error() const noexcept { return m_error; }
+
+private:
+    friend class Graph; // generators that never produce duplicates use build_csr()
+
+    struct Edge { vertex_t u, v; };
+
+    bool record(std::size_t u, std::size_t v);
+    bool find_duplicate();
+    Graph build_csr(); // CSR fill, no duplicate check
+
+    std::size_t m_n{0};
+    std::vector<Edge> m_edges;
+    std::vector<weight_t> m_weights; // parallel to m_edges once any edge has a weight
+    std::optional<Error> m_error;
 };
@@ -0,0 +1,417 @@
+#include "graph.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Whole file as one read-only byte range. Regular files are mmap'ed; pipes
+// and other non-mappable inputs fall back to reading into a buffer.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path, bool sequential = true) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return;
+
+        struct stat st{};
+        if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            void* p = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                if (sequential) ::madvise(p, static_cast<std::size_t>(st.st_size), MADV_SEQUENTIAL);
+                m_map = static_cast<const char*>(p);
+                m_size = static_cast<std::size_t>(st.st_size);
+                m_ok = true;
+            }
+        }
+        if (!m_ok) {
+            char buf[1 << 16];
+            ssize_t r;
+            while ((r = ::read(fd, buf, sizeof(buf))) > 0) m_buf.append(buf, static_cast<std::size_t>(r));
+            m_ok = (r == 0);
+            m_size = m_buf.size();
+        }
+        ::close(fd);
+    }
+    ~MappedFile() {
+        if (m_map) ::munmap(const_cast<char*>(m_map), m_size);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool ok() const noexcept { return m_ok; }
+    const char* begin() const noexcept { return m_map ? m_map : m_buf.data(); }
+    const char* end() const noexcept { return begin() + m_size; }
+    std::size_t size() const noexcept { return m_size; }
+
+private:
+    const char* m_map{nullptr};
+    std::size_t m_size{0};
+    std::string m_buf;
+    bool m_ok{false};
+};
+
+inline bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Unsigned decimal at p (advanced past the digits). At most 19 digits, so
+// the value cannot overflow 64 bits; longer numbers are rejected.
+inline bool parse_uint(const char*& p, const char* end, std::uint64_t& out) {
+    const char* s = p;
+    std::uint64_t v = 0;
+    while (p < end) {
+        unsigned d = static_cast<unsigned>(static_cast<unsigned char>(*p)) - '0';
+        if (d > 9) break;
+        v = v * 10 + d;
+        ++p;
+    }
+    out = v;
+    return p != s && p - s <= 19;
+}
+
+enum class LineKind { Skip, Pair, Triple, Bad };
+
+// Classify the line starting at p as blank/comment, "a b [ignored...]",
+// "a b c [ignored...]" (only when 'c' is given) or malformed. With 'c', a
+// third field starting with a sign or digit must be a whole unsigned number
+// ("-3" and "3x" are malformed); one starting otherwise is ignored. p is
+// left at the start of the next line.
+LineKind scan_line(const char*& p, const char* end, std::uint64_t& a, std::uint64_t& b,
+                   std::uint64_t* c = nullptr) {
+    const char* nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+    const char* eol = nl ? nl : end;
+    const char* q = p;
+    p = nl ? nl + 1 : end;
+
+    if (q < eol && *q == '#') return LineKind::Skip;
+    while (q < eol && is_blank(*q)) ++q;
+    if (q == eol) return LineKind::Skip;
+
+    if (!parse_uint(q, eol, a)) return LineKind::Bad;
+    if (q == eol || !is_blank(*q)) return LineKind::Bad;
+    while (q < eol && is_blank(*q)) ++q;
+    if (!parse_uint(q, eol, b)) return LineKind::Bad;
+    if (!c || q == eol || !is_blank(*q)) return LineKind::Pair;
+    while (q < eol && is_blank(*q)) ++q;
+    if (q == eol || !(*q == '-' || *q == '+' || (*q >= '0' && *q <= '9'))) return LineKind::Pair; // text: ignored
+    if (!parse_uint(q, eol, *c) || (q < eol && !is_blank(*q))) return LineKind::Bad;
+    return LineKind::Triple;
+}
+
+// Edges parsed from one newline-aligned slice of the edge section.
+struct Chunk {
+    std::vector<std::pair<vertex_t, vertex_t>> edges;
+    std::vector<weight_t> weights;       // parallel to edges once a weight was seen
+    std::vector<std::size_t> skipped_at; // edges.size() at each blank/comment line
+    std::size_t lines{0};                // lines consumed, including a failing one
+    const char* error{nullptr};          // set if line 'lines' is invalid
+};
+
+// Parse up to 'limit' edges from [p, end). Range and self-loop checks happen
+// here so that errors carry the right line; duplicates are left to the builder.
+void parse_chunk(const char* p, const char* end, std::size_t n, std::size_t limit, Chunk& c) {
+    std::uint64_t u = 0, v = 0, w = 1;
+    while (p < end && c.edges.size() < limit) {
+        ++c.lines;
+        const LineKind kind = scan_line(p, end, u, v, &w);
+        switch (kind) {
+            case LineKind::Skip:
+                c.skipped_at.push_back(c.edges.size());
+                break;
+            case LineKind::Bad:
+                c.error = "bad edge, expected \"u v [w]\"";
+                return;
+            case LineKind::Pair:
+            case LineKind::Triple:
+                if (u >= n || v >= n) { c.error = "vertex id out of range"; return; }
+                if (u == v) { c.error = "self-loop"; return; }
+                if (kind == LineKind::Triple) {
+                    if (w > static_cast<std::uint64_t>(std::numeric_limits<weight_t>::max())) {
+                        c.error = "weight out of range";
+                        return;
+                    }
+                    if (c.weights.empty()) c.weights.assign(c.edges.size(), 1);
+                    c.weights.push_back(static_cast<weight_t>(w));
+                } else if (!c.weights.empty()) {
+                    c.weights.push_back(1);
+                }
+                c.edges.emplace_back(static_cast<vertex_t>(u), static_cast<vertex_t>(v));
+                break;
+        }
+    }
+}
+
+// ---- Binary format ----
+constexpr char kMagic[8] = {'E', 'U', 'L', 'G', 'R', 'A', 'P', 'H'};
+constexpr std::uint32_t kVersion = 3; // v2: edge-id section, v3: header checksum covers flags
+constexpr std::uint64_t kFlagWeighted = 1; // weight section after the edge ids
+
+struct BinaryHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t id_bytes;
+    std::uint64_t n;
+    std::uint64_t m;
+    std::uint64_t payload_checksum;
+    std::uint64_t header_checksum; // over every other header field
+    std::uint64_t flags;
+    std::uint64_t reserved;
+};
+static_assert(sizeof(BinaryHeader) == 64, "binary header layout");
+static_assert(sizeof(std::size_t) == 8, "offsets are stored as u64");
+
+constexpr bool kLittleEndian = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+
+// Word-wise FNV-1a with an xor-shift fold so high bits feed back into low
+// ones. 'bytes' must be a multiple of 8 (every section is).
+std::uint64_t checksum64(const void* data, std::size_t bytes, std::uint64_t h = 0xcbf29ce484222325ULL) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i + 8 <= bytes; i += 8) {
+        std::uint64_t w;
+        std::memcpy(&w, p + i, 8);
+        h = (h ^ w) * 0x100000001b3ULL;
+        h ^= h >> 32;
+    }
+    return h;
+}
+
+// nullptr if the mapped CSR arrays are safe to index in place: offsets
+// start at 0, never decrease and end at 2m, and every neighbor and edge id
+// is in range. One pass over the file, no allocation.
+const char* csr_structure_error(const std::size_t* offsets, const vertex_t* nbrs, const vertex_t* eids,
+                                std::size_t n, std::size_t m) {
+    if (offsets[0] != 0 || offsets[n] != 2 * m) return "corrupt offsets section";
+    for (std::size_t u = 0; u < n; ++u)
+        if (offsets[u] > offsets[u + 1]) return "corrupt offsets section";
+    for (std::size_t i = 0; i < 2 * m; ++i) {
+        if (nbrs[i] >= n) return "neighbor id out of range";
+        if (eids[i] >= m) return "edge id out of range";
+    }
+    return nullptr;
+}
+
+std::uint64_t header_checksum(const BinaryHeader& h) {
+    constexpr std::size_t kAfter = offsetof(BinaryHeader, header_checksum) + sizeof(h.header_checksum);
+    const std::uint64_t above = checksum64(&h, offsetof(BinaryHeader, header_checksum));
+    return checksum64(reinterpret_cast<const char*>(&h) + kAfter, sizeof(BinaryHeader) - kAfter, above);
+}
+
+} // namespace
+
+// ---------- Text edge list ----------
+std::optional<Graph> Graph::load_from_file(const std::string& path, std::string* error, unsigned threads) {
+    auto fail = [error](std::size_t line_no, const std::string& what) -> std::optional<Graph> {
+        if (error) *error = (line_no ? "line " + std::to_string(line_no) + ": " : std::string()) + what;
+        return std::nullopt;
+    };
+
+    MappedFile file(path);
+    if (!file.ok()) return fail(0, "cannot open file");
+
+    const char* p = file.begin();
+    const char* const end = file.end();
+    std::size_t line_no = 0;
+
+    // First non-empty, non-comment line is "n m"
+    std::uint64_t n64 = 0, m64 = 0;
+    bool have_header = false;
+    while (p < end && !have_header) {
+        ++line_no;
+        LineKind k = scan_line(p, end, n64, m64);
+        if (k == LineKind::Bad) return fail(line_no, "bad header, expected \"n m\"");
+        have_header = (k == LineKind::Pair);
+    }
+    if (!have_header) return fail(line_no, "missing header");
+
+    // Basic validation with 64-bit arithmetic
+    const std::uint64_t max_m = n64 ? (n64 * (n64 - 1)) / 2ull : 0;
+    if (n64 == 0 && m64 != 0) return fail(line_no, "edges on an empty graph");
+    if (m64 > max_m) return fail(line_no, "m exceeds n*(n-1)/2");
+    const std::size_t n = static_cast<std::size_t>(n64);
+    const std::size_t m = static_cast<std::size_t>(m64);
+
+    // Every edge line takes at least 4 bytes ("0 1\n"), so a header m the
+    // file cannot hold is not allowed to size the reservation.
+    const std::size_t bytes = static_cast<std::size_t>(end - p);
+    std::optional<GraphBuilder> b;
+    try {
+        b.emplace(n);
+        b->reserve(std::min(m, bytes / 4 + 1));
+    } catch (const std::exception& e) {
+        return fail(line_no, e.what());
+    }
+
+    // Split the edge section into newline-aligned chunks. Small inputs are
+    // not worth a thread.
+    constexpr std::size_t kMinChunkBytes = 1u << 20;
+    std::size_t parts = std::max<std::size_t>(1, std::min<std::size_t>(threads, bytes / kMinChunkBytes));
+
+    std::vector<const char*> cuts{p};
+    for (std::size_t i = 1; i < parts; ++i) {
+        const char* c = std::max(cuts.back(), p + bytes / parts * i);
+        const char* nl = static_cast<const char*>(std::memchr(c, '\n', static_cast<std::size_t>(end - c)));
+        if (!nl) break;
+        cuts.push_back(nl + 1);
+    }
+    cuts.push_back(end);
+    parts = cuts.size() - 1;
+
+    std::vector<Chunk> chunks(parts);
+    if (parts == 1) {
+        parse_chunk(cuts[0], cuts[1], n, m, chunks[0]);
+    } else {
+        std::vector<std::thread> pool;
+        for (std::size_t i = 0; i < parts; ++i)
+            pool.emplace_back(parse_chunk, cuts[i], cuts[i + 1], n, m, std::ref(chunks[i]));
+        for (auto& t : pool) t.join();
+    }
+
+    // Merge in file order. Anything after the m-th edge is ignored, including
+    // errors, exactly like a sequential reader that stops after m edges.
+    const std::size_t first_edge_line = line_no + 1;
+    std::vector<std::size_t> skipped_at;
+    std::size_t added = 0;
+    for (Chunk& c : chunks) {
+        const std::size_t take = std::min(c.edges.size(), m - added);
+        for (std::size_t s : c.skipped_at) skipped_at.push_back(added + s);
+        if (c.error && added + c.edges.size() < m) return fail(line_no + c.lines, c.error);
+        if (c.weights.empty()) {
+            for (std::size_t i = 0; i < take; ++i) b->add_edge(c.edges[i].first, c.edges[i].second);
+        } else {
+            for (std::size_t i = 0; i < take; ++i) b->add_edge(c.edges[i].first, c.edges[i].second, c.weights[i]);
+        }
+        added += take;
+        line_no += c.lines;
+        std::vector<std::pair<vertex_t, vertex_t>>().swap(c.edges);
+        std::vector<weight_t>().swap(c.weights);
+        if (added == m) break;
+    }
+
+    if (added != m) {
+        return fail(line_no, "expected " + std::to_string(m) + " edges, found " + std::to_string(added));
+    }
+
+    std::optional<Graph> g;
+    try {
+        g = b->build();
+    } catch (const std::exception& e) {
+        return fail(line_no, e.what());
+    }
+    if (!g) {
+        const std::size_t k = b->error()->edge_index;
+        const std::size_t gaps = static_cast<std::size_t>(
+            std::upper_bound(skipped_at.begin(), skipped_at.end(), k) - skipped_at.begin());
+        return fail(first_edge_line + k + gaps, b->error()->what);
+    }
+    return g;
+}
+
+// ---------- Binary graph ----------
+bool Graph::save_binary(const std::string& path, std::string* error) const {
+    auto fail = [error](const std::string& what) {
+        if (error) *error = what;
+        return false;
+    };
+    if (!kLittleEndian) return fail("binary graphs require a little-endian host");
+    if (!m_frozen) return fail("graph must be finalized before saving");
+
+    const std::size_t off_bytes = (m_n + 1) * sizeof(std::size_t);
+    const std::size_t nbr_bytes = 2 * m_m * sizeof(vertex_t);
+    const std::size_t weight_bytes = m_weights ? m_m * sizeof(weight_t) : 0;
+
+    BinaryHeader h{};
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kVersion;
+    h.id_bytes = sizeof(vertex_t);
+    h.n = m_n;
+    h.m = m_m;
+    h.payload_checksum = checksum64(m_eids, nbr_bytes, checksum64(m_nbrs, nbr_bytes, checksum64(m_offsets, off_bytes)));
+    if (m_weights) h.payload_checksum = checksum64(m_weights, weight_bytes, h.payload_checksum);
+    h.flags = m_weights ? kFlagWeighted : 0;
+    h.header_checksum = header_checksum(h);
+
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return fail("cannot create file");
+    bool ok = std::fwrite(&h, sizeof(h), 1, f) == 1 &&
+              std::fwrite(m_offsets, 1, off_bytes, f) == off_bytes &&
+              (nbr_bytes == 0 || (std::fwrite(m_nbrs, 1, nbr_bytes, f) == nbr_bytes &&
+                                  std::fwrite(m_eids, 1, nbr_bytes, f) == nbr_bytes)) &&
+              (weight_bytes == 0 || std::fwrite(m_weights, 1, weight_bytes, f) == weight_bytes);
+    ok = (std::fclose(f) == 0) && ok;
+    return ok ? true : fail("write failed");
+}
+
+std::optional<Graph> Graph::load_binary(const std::string& path, std::string* error, bool verify) {
+    auto fail = [error](const std::string& what) -> std::optional<Graph> {
+        if (error) *error = what;
+        return std::nullopt;
+    };
+    if (!kLittleEndian) return fail("binary graphs require a little-endian host");
+
+    auto file = std::make_shared<MappedFile>(path, /*sequential=*/false);
+    if (!file->ok()) return fail("cannot open file");
+    if (file->size() < sizeof(BinaryHeader)) return fail("file too small for a graph header");
+
+    BinaryHeader h;
+    std::memcpy(&h, file->begin(), sizeof(h));
+    if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0) return fail("not a binary graph file");
+    if (h.version != kVersion) {
+        return fail("unsupported format version " + std::to_string(h.version) + " (re-run convert)");
+    }
+    if (h.header_checksum != header_checksum(h)) return fail("header checksum mismatch");
+    if (h.id_bytes != sizeof(vertex_t)) {
+        return fail("file uses " + std::to_string(h.id_bytes * 8) + "-bit vertex ids, this build uses " +
+                    std::to_string(sizeof(vertex_t) * 8) + "-bit");
+    }
+
+    // Section sizes, guarding against overflow from a forged header
+    if (h.n >= (1ULL << 60) || h.m >= (1ULL << 59)) return fail("header sizes out of range");
+    const std::size_t off_bytes = static_cast<std::size_t>(h.n + 1) * sizeof(std::size_t);
+    const std::size_t nbr_bytes = static_cast<std::size_t>(2 * h.m) * sizeof(vertex_t);
+    if (h.flags & ~kFlagWeighted) return fail("unsupported format flags");
+    const std::size_t weight_bytes = (h.flags & kFlagWeighted) ? static_cast<std::size_t>(h.m) * sizeof(weight_t) : 0;
+    if (file->size() != sizeof(BinaryHeader) + off_bytes + 2 * nbr_bytes + weight_bytes)
+        return fail("file size does not match header");
+
+    const char* base = file->begin();
+    const auto* offsets = reinterpret_cast<const std::size_t*>(base + sizeof(BinaryHeader));
+    const auto* nbrs = reinterpret_cast<const vertex_t*>(base + sizeof(BinaryHeader) + off_bytes);
+    const auto* eids = reinterpret_cast<const vertex_t*>(base + sizeof(BinaryHeader) + off_bytes + nbr_bytes);
+    const auto* weights = reinterpret_cast<const weight_t*>(base + sizeof(BinaryHeader) + off_bytes + 2 * nbr_bytes);
+
+    // Every algorithm indexes these arrays unchecked, so their structure is
+    // always validated; the checksum over the whole payload is opt-in
+    if (h.n > 0 && h.n - 1 > std::numeric_limits<vertex_t>::max()) return fail("too many vertices for vertex_t");
+    if (const char* bad = csr_structure_error(offsets, nbrs, eids, static_cast<std::size_t>(h.n),
+                                              static_cast<std::size_t>(h.m)))
+        return fail(bad);
+    if (verify) {
+        std::uint64_t sum = checksum64(eids, nbr_bytes, checksum64(nbrs, nbr_bytes, checksum64(offsets, off_bytes)));
+        if (weight_bytes) sum = checksum64(weights, weight_bytes, sum);
+        if (h.payload_checksum != sum) return fail("payload checksum mismatch");
+    }
+
+    Graph g(static_cast<std::size_t>(h.n), static_cast<std::size_t>(h.m), file, offsets, nbrs, eids);
+    if (weight_bytes) {
+        g.m_weight_owner = std::move(file);
+        g.m_weights = weights;
+    }
+    return g;
+}
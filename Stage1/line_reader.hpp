@@ -0,0 +1,129 @@
+#pragma once
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+/**
+ * Line-oriented protocol input without per-byte system calls or tokens.
+ *  - LineReader: buffered reader over a blocking fd; one recv()/read() fills
+ *    up to 'capacity' bytes and lines are split with memchr
+ *  - next_field() / parse_size() / parse_fields(): parse numbers in place
+ *    from a std::string_view, no std::string or istringstream per token
+ * Shared by the servers' request parsers (Stage6, Stage7).
+ */
+
+// Next blank-separated field of 'line' (empty at the end); 'line' is
+// advanced past it.
+inline std::string_view next_field(std::string_view& line) {
+    std::size_t i = 0;
+    while (i < line.size() && (line[i] == ' ' || line[i] == '\t')) ++i;
+    std::size_t j = i;
+    while (j < line.size() && line[j] != ' ' && line[j] != '\t') ++j;
+    std::string_view f = line.substr(i, j - i);
+    line.remove_prefix(j);
+    return f;
+}
+
+// Whole token must be decimal digits (at most 19, so no overflow).
+inline bool parse_size(std::string_view tok, std::size_t& out) {
+    if (tok.empty() || tok.size() > 19) return false;
+    std::size_t v = 0;
+    for (char c : tok) {
+        if (c < '0' || c > '9') return false;
+        v = v * 10 + static_cast<std::size_t>(c - '0');
+    }
+    out = v;
+    return true;
+}
+
+// The line holds exactly 'count' numbers separated by blanks ("u v", "n m").
+inline bool parse_fields(std::string_view line, std::size_t* out, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i)
+        if (!parse_size(next_field(line), out[i])) return false;
+    return next_field(line).empty();
+}
+
+class LineReader {
+public:
+    explicit LineReader(int fd, bool socket = false, std::size_t capacity = 1 << 16)
+        : m_fd(fd), m_socket(socket), m_buf(capacity < 64 ? 64 : capacity) {}
+
+    LineReader(const LineReader&) = delete;
+    LineReader& operator=(const LineReader&) = delete;
+
+    // Next line without '\n' (a trailing '\r' is dropped). The view stays
+    // valid until the next call. False at end of input, on a read error or
+    // if a line does not fit the buffer (too_long() then tells which); a
+    // final line without '\n' counts as incomplete.
+    bool next(std::string_view& line) {
+        while (true) {
+            const char* from = m_buf.data() + m_begin + m_scanned;
+            const void* nl = std::memchr(from, '\n', m_end - m_begin - m_scanned);
+            if (nl) {
+                const char* s = m_buf.data() + m_begin;
+                std::size_t len = static_cast<std::size_t>(static_cast<const char*>(nl) - s);
+                m_begin += len + 1;
+                m_scanned = 0;
+                if (len && s[len - 1] == '\r') --len;
+                line = std::string_view(s, len);
+                return true;
+            }
+            m_scanned = m_end - m_begin;
+            if (!fill()) return false;
+        }
+    }
+
+    bool too_long() const noexcept { return m_too_long; }
+
+    // Raw bytes after the last line (binary payloads): buffered input first,
+    // then straight from the fd. False if the input ends early.
+    bool read_exact(char* dst, std::size_t n) {
+        const std::size_t have = std::min(n, m_end - m_begin);
+        std::memcpy(dst, m_buf.data() + m_begin, have);
+        m_begin += have;
+        m_scanned = 0;
+        for (std::size_t got = have; got < n;) {
+            ssize_t r = m_socket ? ::recv(m_fd, dst + got, n - got, 0) : ::read(m_fd, dst + got, n - got);
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) return false;
+            got += static_cast<std::size_t>(r);
+        }
+        return true;
+    }
+
+private:
+    // Move the partial line to the front and read more after it.
+    bool fill() {
+        if (m_begin) {
+            std::memmove(m_buf.data(), m_buf.data() + m_begin, m_end - m_begin);
+            m_end -= m_begin;
+            m_begin = 0;
+        }
+        if (m_end == m_buf.size()) {
+            m_too_long = true;
+            return false;
+        }
+        while (true) {
+            ssize_t r = m_socket ? ::recv(m_fd, m_buf.data() + m_end, m_buf.size() - m_end, 0)
+                                 : ::read(m_fd, m_buf.data() + m_end, m_buf.size() - m_end);
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) return false;
+            m_end += static_cast<std::size_t>(r);
+            return true;
+        }
+    }
+
+    int m_fd;
+    bool m_socket;
+    bool m_too_long{false};
+    std::vector<char> m_buf;
+    std::size_t m_begin{0}, m_end{0};
+    std::size_t m_scanned{0}; // bytes after m_begin known to hold no '\n'
+};
@@ -0,0 +1,296 @@
+#pragma once
+
+#include <signal.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * Server metrics: event counters and a latency histogram per phase of a
+ * request, cheap enough to leave on.
+ *  - Every thread writes only to its own shard (found through a
+ *    thread_local, registered once per thread), with plain relaxed atomic
+ *    loads and stores: no locks, no read-modify-write, no shared cache lines.
+ *  - Histograms are log-linear like HdrHistogram: 16 buckets per power of
+ *    two of nanoseconds (values exact below 16 ns, within 6.25% above), up
+ *    to 2^44 ns (about 4.9 hours; longer times land in the last bucket).
+ *  - snapshot() sums the shards on demand. Gauges (e.g. result cache size)
+ *    are read through callbacks at that moment.
+ * Phases, counters and gauges are fixed at construction and addressed by
+ * index.
+ */
+class Metrics {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr unsigned kSubBits = 4;
+    static constexpr std::size_t kSub = std::size_t{1} << kSubBits;
+    static constexpr unsigned kMaxExponent = 44;
+    static constexpr std::size_t kBuckets = kSub * (kMaxExponent - kSubBits + 2);
+
+    struct Gauge {
+        std::string name;
+        std::function<double()> read;
+    };
+
+    struct PhaseStats {
+        std::uint64_t count{0}, sum_ns{0}, max_ns{0};
+        std::vector<std::uint64_t> buckets; // kBuckets
+
+        // Upper bound of the bucket holding the q-quantile (0 < q <= 1),
+        // capped at the maximum seen; 0 if empty.
+        std::uint64_t quantile_ns(double q) const;
+    };
+
+    struct Snapshot {
+        double uptime_s{0};
+        std::vector<std::pair<std::string_view, std::uint64_t>> counters;
+        std::vector<std::pair<std::string_view, PhaseStats>> phases;
+        std::vector<std::pair<std::string_view, double>> gauges;
+    };
+
+    Metrics(std::vector<std::string> phases, std::vector<std::string> counters, std::vector<Gauge> gauges = {})
+        : m_phases(std::move(phases)), m_counters(std::move(counters)), m_gauges(std::move(gauges)) {}
+
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    void add(std::size_t counter, std::uint64_t k = 1) { bump(shard().counter(counter), k); }
+
+    void record(std::size_t phase, Clock::duration d) {
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+        const std::uint64_t v = ns > 0 ? static_cast<std::uint64_t>(ns) : 0;
+        Shard& s = shard();
+        std::atomic<std::uint64_t>* h = s.phase(phase);
+        bump(h[0], 1);
+        bump(h[1], v);
+        if (v > h[2].load(std::memory_order_relaxed)) h[2].store(v, std::memory_order_relaxed);
+        bump(h[3 + bucket(v)], 1);
+    }
+
+    // Time from 'start' until now; returns now, the start of the next phase.
+    Clock::time_point record_since(std::size_t phase, Clock::time_point start) {
+        const Clock::time_point now = Clock::now();
+        record(phase, now - start);
+        return now;
+    }
+
+    Snapshot snapshot() const;
+
+    // "OK STATS" reply body: "uptime_s x", then one "<counter> <n>" and one
+    // "<gauge> <x>" line each, then per phase with samples
+    // "phase <name> count <n> mean_us <x> p50_us <x> p90_us <x> p99_us <x>
+    // p999_us <x> max_us <x>". No trailing newline.
+    std::string text() const;
+
+    // Prometheus text exposition: counters as <prefix>_<name>_total, gauges
+    // as <prefix>_<name>, phases as the summary <prefix>_phase_seconds with
+    // a "phase" label, plus <prefix>_phase_max_seconds.
+    std::string prometheus(std::string_view prefix) const;
+
+    // Write prometheus() to 'path' (through a temporary file and rename, so
+    // readers never see half a dump). False on I/O errors.
+    bool dump(const std::string& path, std::string_view prefix) const;
+
+    // Bucket of a value in nanoseconds, and the largest value it holds.
+    static std::size_t bucket(std::uint64_t v) {
+        if (v < kSub) return static_cast<std::size_t>(v);
+        unsigned e = 63u - static_cast<unsigned>(__builtin_clzll(v));
+        if (e > kMaxExponent) return kBuckets - 1;
+        return kSub * (e - kSubBits + 1) + static_cast<std::size_t>((v >> (e - kSubBits)) & (kSub - 1));
+    }
+    static std::uint64_t bucket_max(std::size_t b) {
+        if (b < kSub) return b;
+        const unsigned e = static_cast<unsigned>(b / kSub) + kSubBits - 1;
+        const std::uint64_t sub = b % kSub;
+        return ((kSub + sub + 1) << (e - kSubBits)) - 1;
+    }
+
+private:
+    // One thread's numbers: counters, then per phase count, sum, max and
+    // the buckets.
+    struct Shard {
+        Shard(std::size_t phases, std::size_t counters)
+            : n_counters(counters), cells(new std::atomic<std::uint64_t>[counters + phases * (3 + kBuckets)]()) {}
+        std::atomic<std::uint64_t>& counter(std::size_t i) { return cells[i]; }
+        std::atomic<std::uint64_t>* phase(std::size_t i) { return &cells[n_counters + i * (3 + kBuckets)]; }
+
+        std::size_t n_counters;
+        std::unique_ptr<std::atomic<std::uint64_t>[]> cells;
+    };
+
+    // Single writer per shard, so a load and a store suffice.
+    static void bump(std::atomic<std::uint64_t>& a, std::uint64_t k) {
+        a.store(a.load(std::memory_order_relaxed) + k, std::memory_order_relaxed);
+    }
+
+    Shard& shard() {
+        thread_local const Metrics* owner = nullptr;
+        thread_local Shard* mine = nullptr;
+        if (owner != this) {
+            std::lock_guard<std::mutex> lock(m_mu);
+            auto& s = m_by_thread[std::this_thread::get_id()];
+            if (!s) {
+                m_shards.push_back(std::make_unique<Shard>(m_phases.size(), m_counters.size()));
+                s = m_shards.back().get();
+            }
+            owner = this;
+            mine = s;
+        }
+        return *mine;
+    }
+
+    const std::vector<std::string> m_phases, m_counters;
+    const std::vector<Gauge> m_gauges;
+    const Clock::time_point m_start = Clock::now();
+
+    mutable std::mutex m_mu; // shard registration and snapshots
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    std::unordered_map<std::thread::id, Shard*> m_by_thread;
+};
+
+inline std::uint64_t Metrics::PhaseStats::quantile_ns(double q) const {
+    if (count == 0) return 0;
+    const auto rank = static_cast<std::uint64_t>(q * static_cast<double>(count) + 0.5);
+    std::uint64_t seen = 0;
+    for (std::size_t b = 0; b < buckets.size(); ++b) {
+        seen += buckets[b];
+        if (seen >= std::max<std::uint64_t>(rank, 1)) return std::min(bucket_max(b), max_ns);
+    }
+    return max_ns;
+}
+
+inline Metrics::Snapshot Metrics::snapshot() const {
+    Snapshot snap;
+    snap.uptime_s = std::chrono::duration<double>(Clock::now() - m_start).count();
+    for (const auto& name : m_counters) snap.counters.emplace_back(name, 0);
+    for (const auto& name : m_phases) {
+        snap.phases.emplace_back(name, PhaseStats{});
+        snap.phases.back().second.buckets.assign(kBuckets, 0);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mu);
+        for (const auto& s : m_shards) {
+            for (std::size_t i = 0; i < m_counters.size(); ++i)
+                snap.counters[i].second += s->counter(i).load(std::memory_order_relaxed);
+            for (std::size_t p = 0; p < m_phases.size(); ++p) {
+                const std::atomic<std::uint64_t>* h = s->phase(p);
+                PhaseStats& out = snap.phases[p].second;
+                out.count += h[0].load(std::memory_order_relaxed);
+                out.sum_ns += h[1].load(std::memory_order_relaxed);
+                out.max_ns = std::max(out.max_ns, h[2].load(std::memory_order_relaxed));
+                for (std::size_t b = 0; b < kBuckets; ++b) out.buckets[b] += h[3 + b].load(std::memory_order_relaxed);
+            }
+        }
+    }
+    for (const auto& g : m_gauges) snap.gauges.emplace_back(g.name, g.read());
+    return snap;
+}
+
+inline std::string Metrics::text() const {
+    const Snapshot snap = snapshot();
+    std::string out;
+    char buf[256];
+    std::snprintf(buf, sizeof(buf), "uptime_s %.3f", snap.uptime_s);
+    out += buf;
+    for (const auto& [name, v] : snap.counters) {
+        std::snprintf(buf, sizeof(buf), "\n%.*s %llu", static_cast<int>(name.size()), name.data(),
+                      static_cast<unsigned long long>(v));
+        out += buf;
+    }
+    for (const auto& [name, v] : snap.gauges) {
+        std::snprintf(buf, sizeof(buf), "\n%.*s %.17g", static_cast<int>(name.size()), name.data(), v);
+        out += buf;
+    }
+    auto us = [](std::uint64_t ns) { return static_cast<double>(ns) / 1e3; };
+    for (const auto& [name, h] : snap.phases) {
+        if (h.count == 0) continue;
+        std::snprintf(buf, sizeof(buf),
+                      "\nphase %.*s count %llu mean_us %.1f p50_us %.1f p90_us %.1f p99_us %.1f p999_us %.1f "
+                      "max_us %.1f",
+                      static_cast<int>(name.size()), name.data(), static_cast<unsigned long long>(h.count),
+                      us(h.sum_ns) / static_cast<double>(h.count), us(h.quantile_ns(0.5)), us(h.quantile_ns(0.9)),
+                      us(h.quantile_ns(0.99)), us(h.quantile_ns(0.999)), us(h.max_ns));
+        out += buf;
+    }
+    return out;
+}
+
+inline std::string Metrics::prometheus(std::string_view prefix) const {
+    const Snapshot snap = snapshot();
+    const std::string p(prefix);
+    auto number = [](double v) {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.17g", v);
+        return std::string(buf);
+    };
+    auto seconds = [](std::uint64_t ns) {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.9f", static_cast<double>(ns) / 1e9);
+        return std::string(buf);
+    };
+    char uptime[32];
+    std::snprintf(uptime, sizeof(uptime), "%.3f", snap.uptime_s);
+    std::string out = "# TYPE " + p + "_uptime_seconds gauge\n" + p + "_uptime_seconds " + uptime + "\n";
+    for (const auto& [name, v] : snap.counters) {
+        const std::string n = p + "_" + std::string(name) + "_total";
+        out += "# TYPE " + n + " counter\n" + n + " " + std::to_string(v) + "\n";
+    }
+    for (const auto& [name, v] : snap.gauges) {
+        const std::string n = p + "_" + std::string(name);
+        out += "# TYPE " + n + " gauge\n" + n + " " + number(v) + "\n";
+    }
+    static constexpr std::pair<double, const char*> kQuantiles[] = {{0.5, "0.5"}, {0.9, "0.9"}, {0.99, "0.99"},
+                                                                   {0.999, "0.999"}};
+    const std::string sum = p + "_phase_seconds", max = p + "_phase_max_seconds";
+    out += "# TYPE " + sum + " summary\n";
+    for (const auto& [name, h] : snap.phases) {
+        const std::string label = "phase=\"" + std::string(name) + "\"";
+        for (const auto& [q, text] : kQuantiles)
+            out += sum + "{" + label + ",quantile=\"" + text + "\"} " + seconds(h.quantile_ns(q)) + "\n";
+        out += sum + "_sum{" + label + "} " + seconds(h.sum_ns) + "\n";
+        out += sum + "_count{" + label + "} " + std::to_string(h.count) + "\n";
+    }
+    out += "# TYPE " + max + " gauge\n";
+    for (const auto& [name, h] : snap.phases)
+        out += max + "{phase=\"" + std::string(name) + "\"} " + seconds(h.max_ns) + "\n";
+    return out;
+}
+
+inline bool Metrics::dump(const std::string& path, std::string_view prefix) const {
+    const std::string text = prometheus(prefix);
+    const std::string tmp = path + ".tmp";
+    std::FILE* f = std::fopen(tmp.c_str(), "w");
+    if (!f) return false;
+    const bool ok = std::fwrite(text.data(), 1, text.size(), f) == text.size();
+    if (std::fclose(f) != 0 || !ok) return false;
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+// Dump 'metrics' to 'path' on every SIGUSR1, from a detached thread that
+// waits for the signal. Call before any other thread starts: SIGUSR1 is
+// blocked in the calling thread, and threads created later inherit that.
+inline void dump_metrics_on_sigusr1(const Metrics& metrics, std::string path, std::string prefix) {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &set, nullptr);
+    std::thread([&metrics, set, path = std::move(path), prefix = std::move(prefix)] {
+        int sig = 0;
+        while (sigwait(&set, &sig) == 0)
+            if (!metrics.dump(path, prefix)) std::perror(("metrics dump to " + path).c_str());
+    }).detach();
+}
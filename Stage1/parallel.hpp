@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/**
+ * Minimal data-parallel helpers shared by the graph algorithms.
+ *  - default_threads(): hardware concurrency (at least 1)
+ *  - parallel_for(): dynamic scheduling of [0, n) in grains over a few threads
+ *  - ConcurrentDsu: lock-free union-find (CAS linking, path halving)
+ */
+
+inline unsigned default_threads() {
+    unsigned t = std::thread::hardware_concurrency();
+    return t ? t : 1;
+}
+
+// Call f(begin, end) for consecutive grains of [0, n). Workers pull grains
+// from a shared counter, so skewed work (e.g. hub vertices) still balances.
+// Runs inline when threads <= 1 or there is only one grain.
+template <typename F>
+void parallel_for(std::size_t n, unsigned threads, F&& f, std::size_t grain = 4096) {
+    if (n == 0) return;
+    grain = std::max<std::size_t>(grain, 1);
+    const std::size_t grains = (n + grain - 1) / grain;
+    if (threads <= 1 || grains == 1) {
+        f(std::size_t{0}, n);
+        return;
+    }
+
+    std::atomic<std::size_t> next{0};
+    auto worker = [&] {
+        for (std::size_t g; (g = next.fetch_add(1, std::memory_order_relaxed)) < grains;) {
+            f(g * grain, std::min(n, (g + 1) * grain));
+        }
+    };
+    const std::size_t extra = std::min<std::size_t>(threads, grains) - 1;
+    std::vector<std::thread> pool;
+    pool.reserve(extra);
+    for (std::size_t i = 0; i < extra; ++i) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+}
+
+// Union-find safe for concurrent unite()/find(). Roots are always linked
+// under the smaller index, so the parent forest can never form a cycle and
+// the final partition does not depend on thread interleaving.
+template <typename T>
+class ConcurrentDsu {
+public:
+    explicit ConcurrentDsu(std::size_t n) : m_parent(n) {
+        for (std::size_t i = 0; i < n; ++i) m_parent[i].store(static_cast<T>(i), std::memory_order_relaxed);
+    }
+
+    std::size_t size() const noexcept { return m_parent.size(); }
+
+    T find(T x) {
+        while (true) {
+            T p = m_parent[x].load(std::memory_order_acquire);
+            if (p == x) return x;
+            T gp = m_parent[p].load(std::memory_order_acquire);
+            if (p != gp) m_parent[x].compare_exchange_weak(p, gp, std::memory_order_acq_rel); // path halving
+            x = gp;
+        }
+    }
+
+    // Returns true if a and b were in different sets and this call merged them.
+    bool unite(T a, T b) {
+        while (true) {
+            a = find(a);
+            b = find(b);
+            if (a == b) return false;
+            if (a < b) std::swap(a, b);
+            T expected = a;
+            if (m_parent[a].compare_exchange_strong(expected, b, std::memory_order_acq_rel)) return true;
+        }
+    }
+
+    bool same(T a, T b) {
+        while (true) {
+            a = find(a);
+            b = find(b);
+            if (a == b) return true;
+            // a is still a root -> the answer "different" was true at that point
+            if (m_parent[a].load(std::memory_order_acquire) == a) return false;
+        }
+    }
+
+private:
+    std::vector<std::atomic<T>> m_parent;
+};
@@ -1,64 +1,238 @@
 #include "euler.hpp"
-#include <stack>
+#include "parallel.hpp"
 #include <algorithm> // for std::reverse
+#include <atomic>
+#include <cstdint>
+#include <limits>
 
-EulerCheck euler_feasibility(const Graph& G) {
-    if (!G.is_connected_ignoring_isolated())
-        return {false, "Graph is not connected when ignoring isolated vertices"};
-    if (!G.all_even_degrees())
+// deg(u) = off[u+1] - off[u], so every degree is even iff every offset is
+// even (off[0] == 0). Blocks are OR-reduced (vectorizable) and a shared flag
+// lets all workers stop once any odd offset is seen.
+static bool all_even_parallel(const Graph& G, unsigned threads) {
+    const auto off = G.csr_offsets();
+    std::atomic<bool> odd{false};
+    parallel_for(off.size(), threads, [&](std::size_t lo, std::size_t hi) {
+        constexpr std::size_t kBlock = 8192;
+        for (std::size_t b = lo; b < hi && !odd.load(std::memory_order_relaxed); b += kBlock) {
+            const std::size_t e = std::min(hi, b + kBlock);
+            std::size_t acc = 0;
+            for (std::size_t i = b; i < e; ++i) acc |= off[i];
+            if (acc & 1U) odd.store(true, std::memory_order_relaxed);
+        }
+    }, 1u << 16);
+    return !odd.load();
+}
+
+// Union-find over vertices, edges processed in parallel; then every
+// non-isolated vertex must share the root of the first one.
+static bool connected_parallel(const Graph& G, unsigned threads) {
+    const std::size_t n = G.n();
+    std::size_t first = 0;
+    while (first < n && G.degree(first) == 0) ++first;
+    if (first == n) return true;
+
+    ConcurrentDsu<vertex_t> dsu(n);
+    parallel_for(n, threads, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t u = lo; u < hi; ++u)
+            for (vertex_t v : G.neighbors(u))
+                if (v < u) dsu.unite(static_cast<vertex_t>(u), v);
+    }, 1024);
+
+    std::atomic<bool> split{false};
+    const vertex_t root = dsu.find(static_cast<vertex_t>(first));
+    parallel_for(n, threads, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t u = lo; u < hi && !split.load(std::memory_order_relaxed); ++u)
+            if (G.degree(u) != 0 && dsu.find(static_cast<vertex_t>(u)) != root)
+                split.store(true, std::memory_order_relaxed);
+    });
+    return !split.load();
+}
+
+EulerCheck euler_feasibility(const Graph& G, unsigned threads) {
+    const bool parallel = threads > 1 && G.frozen();
+    if (!(parallel ? all_even_parallel(G, threads) : G.all_even_degrees()))
         return {false, "Not all vertices have even degree"};
+    if (!(parallel ? connected_parallel(G, threads) : G.is_connected_ignoring_isolated()))
+        return {false, "Graph is not connected when ignoring isolated vertices"};
     return {true, "OK"};
 }
 
-// Hierholzer’s algorithm for undirected graphs
-std::vector<std::size_t> find_euler_circuit(const Graph& G) {
+// Hierholzer’s algorithm for undirected graphs.
+// Runs directly on the (immutable) graph: each vertex keeps a cursor into its
+// neighbor list and a bitmap marks used edges by edge id, so every adjacency
+// slot is inspected once -> O(n + m) time, one extra bit per edge.
+// Vertices are passed to emit(v) as they are popped (reverse tour order);
+// emit returns false to stop, as does 'cancel'. Requires m > 0.
+template <typename Emit>
+static bool hierholzer(const Graph& G, Emit&& emit, const CancelToken* cancel) {
+    const std::size_t n = G.n();
+    std::vector<std::uint64_t> used((G.m() + 63) / 64, 0);
+    std::vector<std::size_t> cursor(n, 0);
+
+    // Start vertex: first with edges (guaranteed to exist since m>0)
+    std::size_t start = 0;
+    for (std::size_t i = 0; i < n; ++i)
+        if (G.degree(i) != 0) { start = i; break; }
+
+    std::vector<vertex_t> st;
+    st.reserve(G.m() + 1);
+    st.push_back(static_cast<vertex_t>(start));
+
+    CancelPoll poll(cancel);
+    while (!st.empty()) {
+        if (poll()) return false;
+        const std::size_t u = st.back();
+        const auto nb = G.neighbors(u);
+        const auto ids = G.edge_ids(u);
+
+        // Skip edges already walked from the other endpoint
+        std::size_t& c = cursor[u];
+        while (c < nb.size() && (used[ids[c] >> 6] >> (ids[c] & 63) & 1U)) ++c;
+
+        if (c < nb.size()) {
+            used[ids[c] >> 6] |= std::uint64_t{1} << (ids[c] & 63);
+            st.push_back(nb[c]);
+            ++c;
+        } else {
+            if (!emit(u)) return false;
+            st.pop_back();
+        }
+    }
+    return true;
+}
+
+std::vector<std::size_t> find_euler_circuit(const Graph& G, const CancelToken* cancel) {
     auto chk = euler_feasibility(G);
     if (!chk.ok) return {};
 
-    const std::size_t n = G.n();
-    if (n == 0) return {};        // no vertices, no circuit
+    if (G.n() == 0) return {};    // no vertices, no circuit
     if (G.m() == 0) return {};    // no edges -> empty tour (assignment-friendly)
 
-    // Copy adjacency
-    std::vector<std::vector<std::size_t>> adj(n);
-    for (std::size_t u = 0; u < n; ++u)
-        adj[u] = G.neighbors(u);
-
     std::vector<std::size_t> out;
     out.reserve(G.m() + 1);
+    if (!hierholzer(G, [&](std::size_t v) { out.push_back(v); return true; }, cancel)) return {};
 
-    // Start vertex: first with edges (guaranteed to exist since m>0)
-    std::size_t start = 0;
-    for (std::size_t i = 0; i < n; ++i)
-        if (!adj[i].empty()) { start = i; break; }
+    std::reverse(out.begin(), out.end());
+    return out;
+}
 
-    std::stack<std::size_t> st;
-    st.push(start);
+// ---------- Parallel construction ----------
+// Slot p is the directed half-edge stored at csr_neighbors()[p]. With all
+// degrees even every vertex owns an even-aligned, even-length slot range, so
+// the initial pairing (p, p^1) is well defined. A walk that arrives at v
+// through slot q leaves through mate[q]; the pairing therefore decomposes the
+// edges into closed trails, tracked as sets of edge ids in a DSU.
+// Idx is the slot index type (32-bit whenever 2m fits). The circuit is
+// passed to emit(v) in walk order; emit returns false to stop. 'cancel' is
+// checked once per grain of each phase.
+template <typename Idx, typename Emit>
+static bool parallel_circuit(const Graph& G, unsigned threads, Emit&& emit, const CancelToken* cancel) {
+    const std::size_t n = G.n();
+    const std::size_t m = G.m();
+    const auto off = G.csr_offsets();
+    const auto nbr = G.csr_neighbors();
+    const auto eid = G.csr_edge_ids();
 
-    auto remove_edge = [&](std::size_t u, std::size_t v){
-        auto& Au = adj[u];
-        for (std::size_t i = 0; i < Au.size(); ++i) {
-            if (Au[i] == v) { Au[i] = Au.back(); Au.pop_back(); break; }
-        }
-        auto& Av = adj[v];
-        for (std::size_t i = 0; i < Av.size(); ++i) {
-            if (Av[i] == u) { Av[i] = Av.back(); Av.pop_back(); break; }
-        }
+    // 1) Both slots of every edge: side 0 is stored at the smaller endpoint
+    std::vector<Idx> slot_of(2 * m);
+    parallel_for(n, threads, [&](std::size_t lo, std::size_t hi) {
+        if (cancelled(cancel)) return;
+        for (std::size_t u = lo; u < hi; ++u)
+            for (std::size_t p = off[u]; p < off[u + 1]; ++p)
+                slot_of[2 * std::size_t{eid[p]} + (u < nbr[p] ? 0 : 1)] = static_cast<Idx>(p);
+    });
+    auto twin = [&](std::size_t p) -> std::size_t {
+        const std::size_t e = eid[p];
+        return slot_of[2 * e] == p ? slot_of[2 * e + 1] : slot_of[2 * e];
     };
 
-    while (!st.empty()) {
-        std::size_t u = st.top();
-        if (!adj[u].empty()) {
-            std::size_t v = adj[u].back();
-            adj[u].pop_back();
-            remove_edge(u, v);
-            st.push(v);
-        } else {
-            out.push_back(u);
-            st.pop();
+    // 2) Initial pairing and the trails it induces
+    if (cancelled(cancel)) return false;
+    std::vector<Idx> mate(2 * m);
+    ConcurrentDsu<Idx> trails(m);
+    parallel_for(n, threads, [&](std::size_t lo, std::size_t hi) {
+        if (cancelled(cancel)) return;
+        for (std::size_t p = off[lo]; p < off[hi]; p += 2) {
+            mate[p] = static_cast<Idx>(p + 1);
+            mate[p + 1] = static_cast<Idx>(p);
+            trails.unite(static_cast<Idx>(eid[p]), static_cast<Idx>(eid[p + 1]));
+        }
+    });
+
+    // 3) Splice: at each vertex, re-pair the anchor pair (a,b) with any pair
+    //    (c,d) from a different trail as (a,d),(c,b), which joins the two
+    //    trails into one. A successful DSU union is the licence to swap, so
+    //    concurrent splices at different vertices never join a trail twice.
+    if (cancelled(cancel)) return false;
+    parallel_for(n, threads, [&](std::size_t lo, std::size_t hi) {
+        if (cancelled(cancel)) return;
+        for (std::size_t v = lo; v < hi; ++v) {
+            const std::size_t a = off[v];
+            for (std::size_t c = a + 2; c < off[v + 1]; c += 2) {
+                if (!trails.unite(static_cast<Idx>(eid[a]), static_cast<Idx>(eid[c]))) continue;
+                const std::size_t b = mate[a], d = mate[c];
+                mate[a] = static_cast<Idx>(d);
+                mate[d] = static_cast<Idx>(a);
+                mate[c] = static_cast<Idx>(b);
+                mate[b] = static_cast<Idx>(c);
+            }
         }
+    }, 1024);
+
+    // 4) One trail left (the graph is connected); read it off
+    if (cancelled(cancel)) return false;
+    std::size_t start = 0;
+    while (off[start + 1] == off[start]) ++start;
+
+    if (!emit(start)) return false;
+    CancelPoll poll(cancel);
+    for (std::size_t p = off[start], i = 0; i < m; ++i) {
+        if (poll() || !emit(std::size_t{nbr[p]})) return false;
+        p = mate[twin(p)];
     }
+    return true;
+}
 
-    std::reverse(out.begin(), out.end());
+// Pick the slot index width for G.
+template <typename Emit>
+static bool run_parallel_circuit(const Graph& G, unsigned threads, Emit&& emit, const CancelToken* cancel) {
+    if (2 * G.m() <= std::numeric_limits<std::uint32_t>::max())
+        return parallel_circuit<std::uint32_t>(G, threads, emit, cancel);
+    return parallel_circuit<std::uint64_t>(G, threads, emit, cancel);
+}
+
+std::vector<std::size_t> find_euler_circuit_parallel(const Graph& G, unsigned threads, const CancelToken* cancel) {
+    if (threads <= 1 || !G.frozen()) return find_euler_circuit(G, cancel);
+
+    auto chk = euler_feasibility(G, threads);
+    if (!chk.ok) return {};
+    if (G.n() == 0 || G.m() == 0) return {};
+
+    std::vector<std::size_t> out;
+    out.reserve(G.m() + 1);
+    if (!run_parallel_circuit(G, threads, [&](std::size_t v) { out.push_back(v); return true; }, cancel)) return {};
     return out;
 }
+
+// ---------- Streaming ----------
+bool stream_euler_circuit(const Graph& G, const CircuitSink& sink, unsigned threads, const CancelToken* cancel) {
+    if (G.m() == 0) return true;
+
+    // Hand vertices to the sink in fixed-size batches so the per-vertex cost
+    // is a store, not an std::function call.
+    constexpr std::size_t kBatch = 4096;
+    std::vector<std::size_t> batch;
+    batch.reserve(kBatch);
+    auto emit = [&](std::size_t v) {
+        batch.push_back(v);
+        if (batch.size() < kBatch) return true;
+        const bool more = sink(batch.data(), batch.size());
+        batch.clear();
+        return more;
+    };
+
+    const bool done = (threads > 1 && G.frozen()) ? run_parallel_circuit(G, threads, emit, cancel)
+                                                  : hierholzer(G, emit, cancel);
+    if (!done) return false;
+    return batch.empty() || sink(batch.data(), batch.size());
+}
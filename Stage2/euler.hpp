@@ -2,6 +2,8 @@
 #define EULER_HPP
 
 #include "graph.hpp"
+#include "cancel.hpp"
+#include <functional>
 #include <vector>
 #include <string>
 
@@ -10,10 +12,35 @@ struct EulerCheck {
     std::string reason;
 };
 
-// Check if Euler circuit exists
-EulerCheck euler_feasibility(const Graph& G);
+// Check if Euler circuit exists. The degree-parity scan runs first (it only
+// reads the CSR offsets), so most non-Eulerian graphs are rejected without
+// touching the neighbor array. With threads > 1 the parity scan and the
+// connectivity check (lock-free union-find) run in parallel and stop early.
+EulerCheck euler_feasibility(const Graph& G, unsigned threads = 1);
 
-// Return Euler circuit (possibly empty if infeasible)
-std::vector<std::size_t> find_euler_circuit(const Graph& G);
+// Return Euler circuit (possibly empty if infeasible, or if 'cancel' fired
+// during the walk)
+std::vector<std::size_t> find_euler_circuit(const Graph& G, const CancelToken* cancel = nullptr);
+
+// Same result contract as find_euler_circuit, built with 'threads' workers:
+// every vertex pairs up its incident edges, which splits the graph into
+// edge-disjoint closed trails; trails meeting at a vertex are then spliced
+// by swapping pairings until one circuit remains. Uses O(m) words of scratch.
+// Falls back to the serial version for threads <= 1 or unfinalized graphs.
+std::vector<std::size_t> find_euler_circuit_parallel(const Graph& G, unsigned threads,
+                                                     const CancelToken* cancel = nullptr);
+
+// Receives the circuit in order, a chunk of consecutive vertices per call.
+// Returning false stops the walk (e.g. the client went away).
+using CircuitSink = std::function<bool(const std::size_t* vertices, std::size_t count)>;
+
+// Emit an Euler circuit (m+1 vertices, first == last) without materializing
+// it; only the walk's own scratch is kept. G must pass euler_feasibility().
+// The serial walk emits vertices in the order Hierholzer finishes them, i.e.
+// find_euler_circuit's tour reversed (also a valid circuit); threads > 1 uses
+// the parallel construction. Emits nothing for a graph without edges.
+// Returns false if the sink stopped early or 'cancel' fired.
+bool stream_euler_circuit(const Graph& G, const CircuitSink& sink, unsigned threads = 1,
+                          const CancelToken* cancel = nullptr);
 
 #endif // EULER_HPP
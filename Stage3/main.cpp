@@ -1,7 +1,9 @@
 #include "graph.hpp"
 #include "euler.hpp"
+#include "fd_writer.hpp"
 
 #include <getopt.h>     // POSIX getopt(3)
+#include <unistd.h>     // STDOUT_FILENO
 #include <cstdlib>
 #include <iostream>
 #include <optional>
@@ -12,31 +14,87 @@ static void print_usage(const char* prog) {
     std::cerr <<
         "Usage:\n"
         "  " << prog << " -f <graph_file>\n"
-        "  " << prog << " -n <vertices> -m <edges> -s <seed>\n"
+        "  " << prog << " -b <binary_graph>\n"
+        "  " << prog << " -n <vertices> -m <edges> -s <seed> [-e]\n"
+        "  " << prog << " convert <graph_file> <binary_graph> [-t <num>]\n"
         "Options:\n"
-        "  -f <file>   Load graph from file. First line: n m; then m lines: u v\n"
+        "  -f <file>   Load graph from file. First line: n m; then m lines: u v [w]\n"
+        "              (w: non-negative weight; \"-3\" or \"3x\" is an error, a third\n"
+        "              field starting with a letter is ignored)\n"
+        "  -b <file>   Load graph from a binary graph file (mmap, no parsing)\n"
+        "  -V          With -b: also verify the payload checksum (ids and offsets\n"
+        "              are always range-checked)\n"
+        "  -o <file>   Also write the loaded/generated graph as a binary graph file\n"
         "  -n <num>    Number of vertices (random graph mode)\n"
         "  -m <num>    Number of edges (random graph mode)\n"
         "  -s <num>    Random seed (unsigned) (random graph mode)\n"
+        "  -e          Random graph mode: generate a connected all-even-degree graph\n"
+        "              (Euler circuit guaranteed; about m edges)\n"
+        "  -t <num>    Worker threads for parsing/generating the graph and for -p (default 1)\n"
+        "  -p          Check feasibility and build the circuit in parallel (uses -t threads)\n"
         "  -h          Show this help\n";
 }
 
+// euler_app convert <graph_file> <binary_graph> [-t <num>]
+static int convert_main(int argc, char** argv) {
+    unsigned threads = 1;
+    std::vector<std::string> paths;
+    for (int i = 2; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "-t" && i + 1 < argc) {
+            threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            if (threads == 0) threads = 1;
+        } else {
+            paths.push_back(a);
+        }
+    }
+    if (paths.size() != 2) { print_usage(argv[0]); return EXIT_FAILURE; }
+
+    std::string err;
+    auto G = Graph::load_from_file(paths[0], &err, threads);
+    if (!G) {
+        std::cerr << "[error] Failed to load graph from '" << paths[0] << "': " << err << "\n";
+        return EXIT_FAILURE;
+    }
+    if (!G->save_binary(paths[1], &err)) {
+        std::cerr << "[error] Failed to write '" << paths[1] << "': " << err << "\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << "Wrote " << paths[1] << " (n=" << G->n() << ", m=" << G->m() << ")\n";
+    return EXIT_SUCCESS;
+}
+
 int main(int argc, char** argv) {
+    if (argc >= 2 && std::string(argv[1]) == "convert") return convert_main(argc, argv);
+
     std::string file_path;
     bool have_file = false;
+    std::string bin_path, out_path;
+    bool have_bin = false, verify = false, parallel = false, eulerian = false;
 
     std::size_t n = 0;
     std::size_t m = 0;
     unsigned seed = 0;
     bool have_n = false, have_m = false, have_s = false;
+    unsigned threads = 1;
 
     int opt;
-    while ((opt = getopt(argc, argv, "f:n:m:s:h")) != -1) {
+    while ((opt = getopt(argc, argv, "f:b:o:Vn:m:s:t:peh")) != -1) {
         switch (opt) {
             case 'f':
                 file_path = optarg ? std::string(optarg) : std::string();
                 have_file = true;
                 break;
+            case 'b':
+                bin_path = optarg ? std::string(optarg) : std::string();
+                have_bin = true;
+                break;
+            case 'o':
+                out_path = optarg ? std::string(optarg) : std::string();
+                break;
+            case 'V':
+                verify = true;
+                break;
             case 'n':
                 if (!optarg) { print_usage(argv[0]); return EXIT_FAILURE; }
                 n = static_cast<std::size_t>(std::strtoull(optarg, nullptr, 10));
@@ -52,6 +110,17 @@ int main(int argc, char** argv) {
                 seed = static_cast<unsigned>(std::strtoul(optarg, nullptr, 10));
                 have_s = true;
                 break;
+            case 't':
+                if (!optarg) { print_usage(argv[0]); return EXIT_FAILURE; }
+                threads = static_cast<unsigned>(std::strtoul(optarg, nullptr, 10));
+                if (threads == 0) threads = 1;
+                break;
+            case 'p':
+                parallel = true;
+                break;
+            case 'e':
+                eulerian = true;
+                break;
             case 'h':
             default:
                 print_usage(argv[0]);
@@ -61,14 +130,25 @@ int main(int argc, char** argv) {
 
     std::optional<Graph> Gopt;
 
-    if (have_file) {
+    if (have_bin) {
+        if (have_file || have_n || have_m || have_s) {
+            std::cerr << "[info] -b provided; ignoring -f/-n/-m/-s flags.\n";
+        }
+        std::string err;
+        Gopt = Graph::load_binary(bin_path, &err, verify);
+        if (!Gopt) {
+            std::cerr << "[error] Failed to load binary graph from '" << bin_path << "': " << err << "\n";
+            return EXIT_FAILURE;
+        }
+    } else if (have_file) {
         // Prefer file if both provided
         if (have_n || have_m || have_s) {
             std::cerr << "[info] -f provided; ignoring -n/-m/-s flags.\n";
         }
-        Gopt = Graph::load_from_file(file_path);
+        std::string err;
+        Gopt = Graph::load_from_file(file_path, &err, threads);
         if (!Gopt) {
-            std::cerr << "[error] Failed to load graph from '" << file_path << "'.\n";
+            std::cerr << "[error] Failed to load graph from '" << file_path << "': " << err << "\n";
             return EXIT_FAILURE;
         }
     } else {
@@ -78,7 +158,7 @@ int main(int argc, char** argv) {
             return EXIT_FAILURE;
         }
         try {
-            Gopt = Graph::random_simple(n, m, seed);
+            Gopt = eulerian ? Graph::random_eulerian(n, m, seed, threads) : Graph::random_simple(n, m, seed, threads);
         } catch (const std::exception& e) {
             std::cerr << "[error] " << e.what() << "\n";
             return EXIT_FAILURE;
@@ -87,25 +167,39 @@ int main(int argc, char** argv) {
 
     const Graph& G = *Gopt;
 
+    if (!out_path.empty()) {
+        std::string err;
+        if (!G.save_binary(out_path, &err)) {
+            std::cerr << "[error] Failed to write '" << out_path << "': " << err << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
     // Stage 2: feasibility or proof of nonexistence
-    EulerCheck chk = euler_feasibility(G);
+    EulerCheck chk = euler_feasibility(G, parallel ? threads : 1);
     if (!chk.ok) {
         std::cout << "Euler circuit does NOT exist: " << chk.reason << "\n";
         return EXIT_SUCCESS; // program ran fine; graph just isn't Eulerian
     }
 
-    // Find and print Euler circuit
-    std::vector<std::size_t> circuit = find_euler_circuit(G);
-    if (circuit.empty()) {
-        // This can happen for graphs with no edges (convention). It's still OK.
+    if (G.m() == 0) {
+        // No edges -> empty tour by convention. It's still OK.
         std::cout << "Euler circuit exists. (Graph has no edges; empty tour.)\n";
         return EXIT_SUCCESS;
     }
 
+    // Stream the circuit straight to stdout; it is never held in memory
     std::cout << "Euler circuit exists.\n";
-    std::cout << "Length: " << circuit.size() << "\nPath:";
-    for (std::size_t v : circuit) std::cout << ' ' << v;
-    std::cout << "\n";
+    std::cout << "Length: " << G.m() + 1 << "\nPath:" << std::flush;
+    FdWriter out(STDOUT_FILENO);
+    stream_euler_circuit(G, [&](const std::size_t* vs, std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            out.put(' ');
+            out.put_uint(vs[i]);
+        }
+        return out.ok();
+    }, parallel ? threads : 1);
+    out.put('\n');
 
-    return EXIT_SUCCESS;
+    return out.flush() ? EXIT_SUCCESS : EXIT_FAILURE;
 }
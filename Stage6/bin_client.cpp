@@ -0,0 +1,124 @@
+// Reference client for the binary protocol (binary_protocol.hpp).
+// Sends a graph as one GRPH frame and prints the reply in the text
+// protocol's format, so its output can be compared with a FILE request.
+//
+//   ./bin_client 5555 -f graph.txt                     (euler_server)
+//   ./bin_client 5555 -a MST -n 1000 -m 5000 -s 1      (alg_server, ALG MST BIN)
+
+#include <arpa/inet.h>
+#include <getopt.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "graph.hpp"
+#include "binary_protocol.hpp"
+
+// Read exactly n bytes; false if the server closed early.
+static bool recv_all(int fd, char* p, std::size_t n) {
+    while (n) {
+        ssize_t r = ::recv(fd, p, n, 0);
+        if (r <= 0) return false;
+        p += r;
+        n -= static_cast<std::size_t>(r);
+    }
+    return true;
+}
+
+// Header line plus the GRPH frame for G (each edge once, as u < v).
+static void send_graph(FdWriter& out, const std::string& header, const Graph& G) {
+    out.put(header);
+    put_frame_header(out, kFrameGraph, kGraphHeaderBytes + 8 * static_cast<std::uint64_t>(G.m()));
+    put_u32(out, static_cast<std::uint32_t>(G.n()));
+    put_u32(out, static_cast<std::uint32_t>(G.m()));
+    for (std::size_t u = 0; u < G.n(); ++u)
+        for (std::size_t v : G.neighbors(u))
+            if (u < v) {
+                put_u32(out, static_cast<std::uint32_t>(u));
+                put_u32(out, static_cast<std::uint32_t>(v));
+            }
+}
+
+static void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " <port> [-H host] [-a ALG] (-f edges.txt | -n N -m M [-s SEED])\n"
+                 "  -a <name>  Send \"ALG <name> BIN\" (alg_server); default \"EULER BIN\" (euler_server)\n"
+                 "  -f <file>  Upload the graph from an edge-list file\n"
+                 "  -n -m -s   Upload Graph::random_eulerian(n, m, seed)\n"
+                 "  -q         Print a circuit's length but not its vertices\n";
+}
+
+int main(int argc, char** argv) {
+    std::string host = "127.0.0.1", alg, file;
+    std::size_t n = 0, m = 0;
+    unsigned seed = 1;
+    bool quiet = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "H:a:f:n:m:s:qh")) != -1) {
+        switch (opt) {
+            case 'H': host = optarg; break;
+            case 'a': alg = optarg; break;
+            case 'f': file = optarg; break;
+            case 'n': n = std::strtoull(optarg, nullptr, 10); break;
+            case 'm': m = std::strtoull(optarg, nullptr, 10); break;
+            case 's': seed = static_cast<unsigned>(std::strtoul(optarg, nullptr, 10)); break;
+            case 'q': quiet = true; break;
+            default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (optind != argc - 1 || (file.empty() && n == 0)) { usage(argv[0]); return 1; }
+
+    std::optional<Graph> G;
+    std::string err;
+    if (!file.empty()) G = Graph::load_from_file(file, &err);
+    else G = Graph::random_eulerian(n, m, seed);
+    if (!G) { std::cerr << "Error: " << err << "\n"; return 1; }
+    if (G->n() > UINT32_MAX || G->m() > UINT32_MAX) { std::cerr << "Error: graph too large for 32-bit frames\n"; return 1; }
+
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(std::stoi(argv[optind])));
+    if (::inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1 ||
+        ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        perror("connect");
+        return 2;
+    }
+    {
+        FdWriter out(fd, /*socket=*/true);
+        send_graph(out, alg.empty() ? "EULER BIN\n" : "ALG " + alg + " BIN\n", *G);
+        if (!out.flush()) { perror("send"); return 2; }
+    }
+    ::shutdown(fd, SHUT_WR);
+
+    char hdr[kFrameHeaderBytes];
+    if (!recv_all(fd, hdr, sizeof(hdr))) { std::cerr << "Error: no reply\n"; return 3; }
+    const std::uint32_t type = load_u32(hdr);
+    std::vector<char> payload(load_u64(hdr + 4));
+    if (!recv_all(fd, payload.data(), payload.size())) { std::cerr << "Error: truncated reply\n"; return 3; }
+    ::close(fd);
+
+    FdWriter out(STDOUT_FILENO);
+    if (type == kFrameText) {
+        out.put(std::string_view(payload.data(), payload.size()));
+        out.put("\nEND\n");
+        return 0;
+    }
+    if (type != kFrameCircuit || payload.size() % 4) { std::cerr << "Error: unexpected frame\n"; return 3; }
+    const std::size_t count = payload.size() / 4;
+    out.put("OK CIRCUIT ");
+    out.put_uint(count ? count - 1 : 0);
+    out.put('\n');
+    if (quiet) return 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        if (i) out.put(' ');
+        out.put_uint(load_u32(payload.data() + 4 * i));
+    }
+    out.put("\nEND\n");
+    return 0;
+}
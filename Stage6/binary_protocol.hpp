@@ -0,0 +1,118 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "graph.hpp"
+#include "euler.hpp"
+#include "fd_writer.hpp"
+
+/**
+ * Binary framing, selected by the input keyword BIN in place of FILE:
+ *   Stage6:  "EULER BIN\n"       + GRPH frame
+ *   Stage7:  "ALG <NAME> BIN\n"  + GRPH frame
+ * and answered by exactly one frame (no END line).
+ *
+ * Frame: u32 type | u64 payload bytes | payload. All integers little-endian.
+ *   GRPH  u32 n | u32 m | m x (u32 u | u32 v)        request graph
+ *   CIRC  (m+1) x u32 vertex (empty if m == 0)        Euler circuit
+ *   TEXT  "OK ..." or "ERR ..." as in the text protocol, without "\nEND\n"
+ */
+
+constexpr std::uint32_t frame_tag(const char (&s)[5]) {
+    return static_cast<std::uint32_t>(static_cast<unsigned char>(s[0])) |
+           static_cast<std::uint32_t>(static_cast<unsigned char>(s[1])) << 8 |
+           static_cast<std::uint32_t>(static_cast<unsigned char>(s[2])) << 16 |
+           static_cast<std::uint32_t>(static_cast<unsigned char>(s[3])) << 24;
+}
+
+constexpr std::uint32_t kFrameGraph = frame_tag("GRPH");
+constexpr std::uint32_t kFrameCircuit = frame_tag("CIRC");
+constexpr std::uint32_t kFrameText = frame_tag("TEXT");
+constexpr std::size_t kFrameHeaderBytes = 12;
+constexpr std::size_t kGraphHeaderBytes = 8; // n, m at the start of a GRPH payload
+
+inline std::uint32_t load_u32(const char* p) {
+    unsigned char b[4];
+    std::memcpy(b, p, 4);
+    return static_cast<std::uint32_t>(b[0]) | static_cast<std::uint32_t>(b[1]) << 8 |
+           static_cast<std::uint32_t>(b[2]) << 16 | static_cast<std::uint32_t>(b[3]) << 24;
+}
+
+inline std::uint64_t load_u64(const char* p) {
+    return static_cast<std::uint64_t>(load_u32(p)) | static_cast<std::uint64_t>(load_u32(p + 4)) << 32;
+}
+
+inline void store_u32(char* p, std::uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = static_cast<char>(v >> (8 * i));
+}
+
+inline void put_u32(FdWriter& out, std::uint32_t v) {
+    char b[4];
+    store_u32(b, v);
+    out.put(std::string_view(b, 4));
+}
+
+inline void put_frame_header(FdWriter& out, std::uint32_t type, std::uint64_t bytes) {
+    char b[kFrameHeaderBytes];
+    store_u32(b, type);
+    store_u32(b + 4, static_cast<std::uint32_t>(bytes));
+    store_u32(b + 8, static_cast<std::uint32_t>(bytes >> 32));
+    out.put(std::string_view(b, sizeof(b)));
+}
+
+// TEXT frame for a text-protocol result; a trailing "\nEND\n" is dropped.
+inline std::string text_frame(std::string_view text) {
+    constexpr std::string_view kEnd = "\nEND\n";
+    if (text.size() >= kEnd.size() && text.substr(text.size() - kEnd.size()) == kEnd)
+        text.remove_suffix(kEnd.size());
+    std::string f(kFrameHeaderBytes, '\0');
+    store_u32(&f[0], kFrameText);
+    store_u32(&f[4], static_cast<std::uint32_t>(text.size()));
+    f.append(text);
+    return f;
+}
+
+inline void write_text_frame(FdWriter& out, std::string_view text) { out.put(text_frame(text)); }
+
+// Stream the Euler circuit of G as a CIRC frame. G must be Eulerian and
+// every vertex id must fit 32 bits. Returns false if the peer went away or
+// 'cancel' fired; the frame is then short and the connection unusable.
+inline bool write_circuit_frame(FdWriter& out, const Graph& G, const CancelToken* cancel = nullptr) {
+    const std::uint64_t count = G.m() ? static_cast<std::uint64_t>(G.m()) + 1 : 0;
+    put_frame_header(out, kFrameCircuit, count * 4);
+    char packed[4 * 1024];
+    return stream_euler_circuit(G, [&](const std::size_t* vs, std::size_t n) {
+        for (std::size_t i = 0; i < n;) {
+            std::size_t k = 0;
+            for (; k < sizeof(packed) && i < n; k += 4, ++i) store_u32(packed + k, static_cast<std::uint32_t>(vs[i]));
+            out.put(std::string_view(packed, k));
+        }
+        return out.ok();
+    }, 1, cancel);
+}
+
+// Check the frame header and n, m at 'p' (kFrameHeaderBytes +
+// kGraphHeaderBytes bytes) of a GRPH request. False unless the payload
+// length matches m.
+inline bool read_graph_header(const char* p, std::size_t& n, std::size_t& m) {
+    if (load_u32(p) != kFrameGraph) return false;
+    const std::uint64_t bytes = load_u64(p + 4);
+    n = load_u32(p + kFrameHeaderBytes);
+    m = load_u32(p + kFrameHeaderBytes + 4);
+    return bytes == kGraphHeaderBytes + 8 * static_cast<std::uint64_t>(m);
+}
+
+// Add 'count' packed (u, v) pairs from 'p'; false once one is rejected.
+inline bool add_packed_edges(GraphBuilder& b, const char* p, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i, p += 8)
+        if (!b.add_edge(load_u32(p), load_u32(p + 4))) return false;
+    return true;
+}
+
+// "ERR <what> at edge <i>" for a rejected GRPH edge (0-based index).
+inline std::string binary_edge_error(const GraphBuilder::Error& e) {
+    return "ERR " + e.what + " at edge " + std::to_string(e.edge_index);
+}
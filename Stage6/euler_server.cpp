@@ -1,76 +1,216 @@
 #include <arpa/inet.h>
+#include <getopt.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 #include "graph.hpp"
 #include "euler.hpp"
+#include "line_reader.hpp"
+#include "metrics.hpp"
+#include "result_cache.hpp"
+#include "binary_protocol.hpp"
 #include "server_protocol.hpp"
 
-static bool recv_line(int fd, std::string& line) {
-    line.clear();
-    char c;
-    while (true) {
-        ssize_t r = ::recv(fd, &c, 1, 0);
-        if (r <= 0) return false;
-        if (c == '\n') break;
-        line.push_back(c);
-    }
-    if (!line.empty() && line.back() == '\r') line.pop_back();
-    return true;
+// Latency phases: request input complete (from accept), graph generated or
+// built, circuit found (including output streamed as it goes), reply
+// flushed, and accept to close.
+enum Phase : size_t { kReceive, kBuild, kEuler, kSend, kTotal };
+enum Counter : size_t { kConnections, kRequests, kStatsRequests, kBadRequests };
+
+static std::unique_ptr<Metrics> make_metrics(const ResultCache& cache) {
+    auto num = [](auto v) { return static_cast<double>(v); };
+    return std::make_unique<Metrics>(
+        std::vector<std::string>{"receive", "build", "EULER", "send", "total"},
+        std::vector<std::string>{"connections", "requests", "stats_requests", "bad_requests"},
+        std::vector<Metrics::Gauge>{{"cache_hits", [&cache, num] { return num(cache.stats().hits); }},
+                                    {"cache_misses", [&cache, num] { return num(cache.stats().misses); }},
+                                    {"cache_entries", [&cache, num] { return num(cache.stats().entries); }},
+                                    {"cache_bytes", [&cache, num] { return num(cache.stats().bytes); }}});
 }
+
 static bool send_str(int fd, const std::string& s) {
     const char* p = s.c_str(); size_t left = s.size();
     while (left) { ssize_t w = ::send(fd, p, left, 0); if (w <= 0) return false; p += w; left -= (size_t)w; }
     return true;
 }
 
-static bool handle_client(int fd) {
-    std::string line;
-    if (!recv_line(fd, line)) return false;
-    auto toks = split_ws(line);
-    if (toks.size() < 2 || toks[0] != "EULER") { send_str(fd, "ERR bad request\nEND\n"); return true; }
+// "EULER BIN": one GRPH frame in, one CIRC or TEXT frame out.
+static void handle_binary(int fd, LineReader& in, Metrics& metrics, Metrics::Clock::time_point t) {
+    FdWriter out(fd, /*socket=*/true);
+    char hdr[kFrameHeaderBytes + kGraphHeaderBytes];
+    size_t n = 0, m = 0;
+    if (!in.read_exact(hdr, sizeof(hdr)) || !read_graph_header(hdr, n, m)) { write_text_frame(out, "ERR bad frame"); return; }
+    std::optional<GraphBuilder> b;
+    try { b.emplace(n); } catch (const std::exception& e) { write_text_frame(out, std::string("ERR ") + e.what()); return; }
+    b->reserve(std::min<size_t>(m, size_t{1} << 20));
+    std::vector<char> chunk(std::min<size_t>(m, size_t{1} << 16) * 8);
+    for (size_t done = 0; done < m;) {
+        const size_t k = std::min(m - done, chunk.size() / 8);
+        if (!in.read_exact(chunk.data(), k * 8)) { write_text_frame(out, "ERR missing edges"); return; }
+        if (!add_packed_edges(*b, chunk.data(), k)) { write_text_frame(out, binary_edge_error(*b->error())); return; }
+        done += k;
+    }
+    t = metrics.record_since(kReceive, t);
+    std::optional<Graph> built;
+    try { built = b->build(); } catch (const std::exception& e) { write_text_frame(out, std::string("ERR ") + e.what()); return; }
+    t = metrics.record_since(kBuild, t);
+    if (!built) { write_text_frame(out, binary_edge_error(*b->error())); return; }
+    auto chk = euler_feasibility(*built);
+    if (!chk.ok) { write_text_frame(out, "ERR " + chk.reason); return; }
+    write_circuit_frame(out, *built);
+    t = metrics.record_since(kEuler, t);
+    out.flush();
+    metrics.record_since(kSend, t);
+}
+
+// Drop a trailing NOCACHE field; true if there was one.
+static bool strip_nocache(std::string_view& line) {
+    constexpr std::string_view kTag = "NOCACHE";
+    while (!line.empty() && (line.back() == ' ' || line.back() == '\t')) line.remove_suffix(1);
+    if (line.size() <= kTag.size() || line.substr(line.size() - kTag.size()) != kTag) return false;
+    const char before = line[line.size() - kTag.size() - 1];
+    if (before != ' ' && before != '\t') return false;
+    line.remove_suffix(kTag.size());
+    return true;
+}
+
+// One request on a connection accepted at 't'.
+static bool handle_client(int fd, ResultCache& cache, Metrics& metrics, Metrics::Clock::time_point t) {
+    LineReader in(fd, /*socket=*/true);
+    std::string_view line;
+    if (!in.next(line)) return false;
+    metrics.add(kRequests);
+    std::string_view rest = line;
+    const bool use_cache = !strip_nocache(rest) && cache.enabled();
+    const std::string_view cmd = next_field(rest);
+    if (cmd == "STATS" && next_field(rest).empty()) {
+        metrics.add(kStatsRequests);
+        send_str(fd, "OK STATS\n" + metrics.text() + "\nEND\n");
+        return true;
+    }
+    if (cmd != "EULER") {
+        metrics.add(kBadRequests);
+        send_str(fd, "ERR bad request\nEND\n");
+        return true;
+    }
+    const std::string mode(next_field(rest));
 
-    Graph G;
-    if (toks[1] == "RAND") {
-        if (toks.size() != 5) { send_str(fd, "ERR RAND usage\nEND\n"); return true; }
-        size_t n = std::stoul(toks[2]), m = std::stoul(toks[3]);
-        unsigned seed = (unsigned)std::stoul(toks[4]);
-        try { G = Graph::random_simple(n, m, seed); }
+    Graph G(0);
+    std::string key; // result cache key, empty when not caching
+    auto cached = [&] {
+        auto hit = cache.get("EULER", key);
+        if (!hit) return false;
+        const auto from = Metrics::Clock::now();
+        send_str(fd, *hit);
+        metrics.record_since(kSend, from);
+        return true;
+    };
+    if (mode == "RAND" || mode == "ERAND") {
+        size_t nms[3];
+        if (!parse_fields(rest, nms, 3)) { send_str(fd, "ERR " + mode + " usage\nEND\n"); return true; }
+        t = metrics.record_since(kReceive, t);
+        if (use_cache) {
+            key = random_graph_key(mode == "ERAND", nms[0], nms[1], (unsigned)nms[2]);
+            if (cached()) return true;
+        }
+        try { G = mode == "ERAND" ? Graph::random_eulerian(nms[0], nms[1], (unsigned)nms[2]) : Graph::random_simple(nms[0], nms[1], (unsigned)nms[2]); }
         catch (const std::exception& e) { send_str(fd, std::string("ERR ") + e.what() + "\nEND\n"); return true; }
-    } else if (toks[1] == "FILE") {
-        if (!recv_line(fd, line)) { send_str(fd, "ERR missing n m\nEND\n"); return true; }
-        auto nm = split_ws(line);
-        if (nm.size() != 2) { send_str(fd, "ERR bad n m\nEND\n"); return true; }
-        size_t n = std::stoul(nm[0]), m = std::stoul(nm[1]);
-        G = Graph(n);
+        t = metrics.record_since(kBuild, t);
+    } else if (mode == "FILE") {
+        if (!in.next(line)) { send_str(fd, "ERR missing n m\nEND\n"); return true; }
+        size_t nm[2];
+        if (!parse_fields(line, nm, 2)) { send_str(fd, "ERR bad n m\nEND\n"); return true; }
+        const size_t m = nm[1];
+        std::optional<GraphBuilder> b;
+        try { b.emplace(nm[0]); } catch (const std::exception& e) { send_str(fd, std::string("ERR ") + e.what() + "\nEND\n"); return true; }
+        b->reserve(std::min<size_t>(m, size_t{1} << 20));
+        // Edge i arrives on request line i+3 (after the command and "n m")
         for (size_t i = 0; i < m; ++i) {
-            if (!recv_line(fd, line)) { send_str(fd, "ERR missing edges\nEND\n"); return true; }
-            auto uv = split_ws(line);
-            if (uv.size() != 2) { send_str(fd, "ERR bad edge\nEND\n"); return true; }
-            size_t u = std::stoul(uv[0]), v = std::stoul(uv[1]);
-            if (!G.add_edge(u, v)) { send_str(fd, "ERR invalid/duplicate edge\nEND\n"); return true; }
+            if (!in.next(line)) { send_str(fd, "ERR missing edges\nEND\n"); return true; }
+            size_t uv[2];
+            if (!parse_fields(line, uv, 2)) { send_str(fd, "ERR bad edge\nEND\n"); return true; }
+            if (!b->add_edge(uv[0], uv[1])) { send_str(fd, edge_error(*b->error(), 3)); return true; }
         }
-        if (!recv_line(fd, line) || line != "END") { send_str(fd, "ERR expected END\nEND\n"); return true; }
-    } else { send_str(fd, "ERR unknown command\nEND\n"); return true; }
+        if (!in.next(line) || line != "END") { send_str(fd, "ERR expected END\nEND\n"); return true; }
+        t = metrics.record_since(kReceive, t);
+        std::optional<Graph> built;
+        try { built = b->build(); } catch (const std::exception& e) { send_str(fd, std::string("ERR ") + e.what() + "\nEND\n"); return true; }
+        t = metrics.record_since(kBuild, t);
+        if (!built) { send_str(fd, edge_error(*b->error(), 3)); return true; }
+        G = std::move(*built);
+        if (use_cache) {
+            key = graph_digest_key(G);
+            if (cached()) return true;
+        }
+    } else if (mode == "BIN" && rest.find_first_not_of(" \t") == std::string_view::npos) {
+        handle_binary(fd, in, metrics, t);
+        return true;
+    } else {
+        metrics.add(kBadRequests);
+        send_str(fd, "ERR unknown command\nEND\n");
+        return true;
+    }
 
     auto chk = euler_feasibility(G);
-    if (!chk.ok) { send_str(fd, std::string("ERR ") + chk.reason + "\nEND\n"); return true; }
-    auto tour = find_euler_circuit(G);
-    send_str(fd, "OK CIRCUIT " + std::to_string(tour.size() - 1) + "\n");
-    send_str(fd, join_sp(tour) + "\nEND\n");
+    FdWriter out(fd, /*socket=*/true);
+    // The reply is streamed; with caching on, a copy is kept if it is small enough
+    auto write_reply = [&](FdWriter& w) {
+        if (!chk.ok) {
+            w.put("ERR ");
+            w.put(chk.reason);
+            w.put("\nEND\n");
+            return true;
+        }
+        w.put("OK CIRCUIT ");
+        w.put_uint(G.m());
+        w.put('\n');
+        const bool done = write_circuit(w, G);
+        t = metrics.record_since(kEuler, t);
+        w.put("\nEND\n");
+        // A circuit cut short by a failed send is not the answer: never keep it
+        return done && w.ok();
+    };
+    if (!key.empty()) cache.write_through("EULER", key, out, write_reply);
+    else write_reply(out);
+    out.flush();
+    if (chk.ok) metrics.record_since(kSend, t);
     return true;
 }
 
+static void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " <port> [-C cache-MiB] [-P metrics-file]\n"
+                 "  -C <MiB>  Memory for cached replies to repeated graphs, 0 disables\n"
+                 "            the cache (default 256)\n"
+                 "  -P <file> Where SIGUSR1 writes the metrics (STATS) in Prometheus text\n"
+                 "            format (default euler_server.prom)\n";
+}
+
 int main(int argc, char** argv) {
-    if (argc != 2) { std::cerr << "Usage: " << argv[0] << " <port>\n"; return 1; }
-    int port = std::stoi(argv[1]);
+    size_t cache_mib = 256;
+    std::string metrics_file = "euler_server.prom";
+    int o;
+    while ((o = getopt(argc, argv, "C:P:h")) != -1) {
+        if (o == 'C') cache_mib = std::strtoul(optarg, nullptr, 10);
+        else if (o == 'P') metrics_file = optarg;
+        else { usage(argv[0]); return o == 'h' ? 0 : 1; }
+    }
+    if (optind != argc - 1) { usage(argv[0]); return 1; }
+    int port = std::stoi(argv[optind]);
+    ResultCache cache(cache_mib << 20);
+    auto metrics = make_metrics(cache);
+    dump_metrics_on_sigusr1(*metrics, metrics_file, "euler_server");
 
     int s = ::socket(AF_INET, SOCK_STREAM, 0);
     if (s < 0) { perror("socket"); return 2; }
@@ -83,5 +223,13 @@ int main(int argc, char** argv) {
     if (::listen(s, 64) < 0) { perror("listen"); return 4; }
 
     std::cout << "Euler server listening on port " << port << "...\n";
-    while (true) { int c = ::accept(s, nullptr, nullptr); if (c < 0) { perror("accept"); continue; } handle_client(c); ::close(c); }
+    while (true) {
+        int c = ::accept(s, nullptr, nullptr);
+        if (c < 0) { perror("accept"); continue; }
+        const auto t = Metrics::Clock::now();
+        metrics->add(kConnections);
+        handle_client(c, cache, *metrics, t);
+        ::close(c);
+        metrics->record_since(kTotal, t);
+    }
 }
@@ -0,0 +1,153 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#include "fd_writer.hpp"
+#include "graph.hpp"
+
+/**
+ * Results of earlier requests, keyed by algorithm + graph key, so a
+ * resubmitted graph is answered without rebuilding or recomputing.
+ *  - random_graph_key(): RAND/ERAND parameters (checked before generating)
+ *  - graph_digest_key(): canonical content hash of a built graph; the same
+ *    edge set (and weights) gives the same key whatever the upload order or
+ *    orientation
+ * Entries are evicted least recently used first once their total size
+ * exceeds the budget; a budget of 0 disables the cache. One result larger
+ * than entry_limit() is never kept: it would evict most of the others, and
+ * write_through() stops copying it as soon as it gets that large. Safe to
+ * share between threads.
+ */
+
+inline std::string random_graph_key(bool eulerian, std::size_t n, std::size_t m, unsigned seed) {
+    return (eulerian ? "ERAND " : "RAND ") + std::to_string(n) + " " + std::to_string(m) + " " +
+           std::to_string(seed);
+}
+
+inline std::string graph_digest_key(const Graph& G) {
+    auto mix = [](std::uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    };
+    // Sums of per-edge hashes do not depend on edge order; two independent
+    // 64-bit sums keep accidental collisions out of reach.
+    std::uint64_t a = 0, b = 0;
+    for (std::size_t u = 0; u < G.n(); ++u) {
+        const auto nbrs = G.neighbors(u);
+        const auto eids = G.edge_ids(u);
+        for (std::size_t i = 0; i < nbrs.size(); ++i)
+            if (const std::size_t v = nbrs[i]; u < v) {
+                const std::uint64_t e = ((static_cast<std::uint64_t>(u) << 32) ^ v) +
+                                        mix(static_cast<std::uint64_t>(G.weight(eids[i])));
+                a += mix(e);
+                b += mix(e ^ 0x9e3779b97f4a7c15ULL);
+            }
+    }
+    char buf[80];
+    std::snprintf(buf, sizeof(buf), "G %zu %zu %016llx%016llx", G.n(), G.m(), static_cast<unsigned long long>(a),
+                  static_cast<unsigned long long>(b));
+    return buf;
+}
+
+class ResultCache {
+public:
+    struct Stats {
+        std::uint64_t hits, misses;
+        std::size_t entries, bytes;
+    };
+
+    explicit ResultCache(std::size_t budget_bytes) : m_budget(budget_bytes) {}
+
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    bool enabled() const noexcept { return m_budget > 0; }
+
+    // Largest entry (key + result) that is kept: 1/8 of the budget.
+    std::size_t entry_limit() const noexcept { return m_budget / 8; }
+
+    // Cached result of 'alg' on the graph with key 'graph', or nullptr.
+    std::shared_ptr<const std::string> get(std::string_view alg, const std::string& graph) {
+        const std::string key = make_key(alg, graph);
+        std::lock_guard<std::mutex> lock(m_mu);
+        auto it = m_index.find(key);
+        if (it == m_index.end()) {
+            ++m_misses;
+            return nullptr;
+        }
+        ++m_hits;
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        return it->second->value;
+    }
+
+    // Store a result; one larger than entry_limit() is not kept.
+    void put(std::string_view alg, const std::string& graph, std::string value) {
+        std::string key = make_key(alg, graph);
+        const std::size_t bytes = key.size() + value.size();
+        if (bytes > entry_limit()) return;
+
+        auto shared = std::make_shared<const std::string>(std::move(value));
+        std::lock_guard<std::mutex> lock(m_mu);
+        auto it = m_index.find(key);
+        if (it != m_index.end()) { // computed twice concurrently: keep the first
+            m_lru.splice(m_lru.begin(), m_lru, it->second);
+            return;
+        }
+        while (m_bytes + bytes > m_budget) {
+            m_bytes -= m_lru.back().bytes;
+            m_index.erase(m_lru.back().key);
+            m_lru.pop_back();
+        }
+        m_lru.push_front(Entry{key, std::move(shared), bytes});
+        m_index.emplace(std::move(key), m_lru.begin());
+        m_bytes += bytes;
+    }
+
+    // Run write(out), which streams a result and returns whether it may be
+    // kept (false if it was cut short, e.g. by a failed send), and store a
+    // copy of what it wrote unless that outgrew entry_limit(); a large
+    // result is streamed without being built first.
+    template <class Write>
+    void write_through(std::string_view alg, const std::string& graph, FdWriter& out, Write&& write) {
+        std::string value;
+        out.tee(value, entry_limit() - std::min(entry_limit(), alg.size() + 1 + graph.size()));
+        const bool keep = write(out);
+        if (out.end_tee() && keep) put(alg, graph, std::move(value));
+    }
+
+    Stats stats() const {
+        std::lock_guard<std::mutex> lock(m_mu);
+        return Stats{m_hits, m_misses, m_lru.size(), m_bytes};
+    }
+
+private:
+    struct Entry {
+        std::string key;
+        std::shared_ptr<const std::string> value;
+        std::size_t bytes;
+    };
+
+    static std::string make_key(std::string_view alg, const std::string& graph) {
+        std::string key(alg);
+        key += '|';
+        key += graph;
+        return key;
+    }
+
+    mutable std::mutex m_mu;
+    std::list<Entry> m_lru; // front = most recently used
+    std::unordered_map<std::string, std::list<Entry>::iterator> m_index;
+    std::size_t m_budget;
+    std::size_t m_bytes{0};
+    std::uint64_t m_hits{0}, m_misses{0};
+};
@@ -1,16 +1,26 @@
 #pragma once
 #include <string>
-#include <vector>
-#include <sstream>
 
-inline std::vector<std::string> split_ws(const std::string& s) {
-    std::istringstream is(s);
-    std::vector<std::string> out; std::string t;
-    while (is >> t) out.push_back(t);
-    return out;
+#include "graph.hpp"
+#include "euler.hpp"
+#include "fd_writer.hpp"
+
+// Stream the Euler circuit of G as "v0 v1 ... vm" (no trailing newline).
+// G must be Eulerian. Returns false if the peer went away or 'cancel' fired.
+inline bool write_circuit(FdWriter& out, const Graph& G, const CancelToken* cancel = nullptr) {
+    bool first = true;
+    return stream_euler_circuit(G, [&](const size_t* vs, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            if (!first) out.put(' ');
+            first = false;
+            out.put_uint(vs[i]);
+        }
+        return out.ok();
+    }, 1, cancel);
 }
-inline std::string join_sp(const std::vector<size_t>& xs) {
-    std::ostringstream os;
-    for (size_t i = 0; i < xs.size(); ++i) { if (i) os << ' '; os << xs[i]; }
-    return os.str();
+
+// "ERR <what> on line <k>\nEND\n" for a rejected FILE upload edge;
+// 'first_line' is the request line that carries edge 0.
+inline std::string edge_error(const GraphBuilder::Error& e, size_t first_line) {
+    return "ERR " + e.what + " on line " + std::to_string(first_line + e.edge_index) + "\nEND\n";
 }
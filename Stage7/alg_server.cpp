@@ -1,160 +1,355 @@
 #include <arpa/inet.h>
+#include <fcntl.h>
+#include <getopt.h>
 #include <netinet/in.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
 #include <cstring>
+#include <cstdint>
 #include <iostream>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include "graph.hpp"
-#include "../Stage6/server_protocol.hpp"
-#include "algorithms.hpp"        // GraphAlgorithm + factory
+#include "parallel.hpp"
+#include "pipeline.hpp"
+#include "request.hpp"           // incremental parser + execute_request
+#include "request_watcher.hpp"
+#include "server_metrics.hpp"
+#include "worker_pool.hpp"
 
-// Receive one line from socket
-static bool recv_line(int fd, std::string& line) {
-    line.clear();
-    char c;
-    while (true) {
-        ssize_t r = ::recv(fd, &c, 1, 0);
-        if (r <= 0) return false;
-        if (c == '\n') break;
-        line.push_back(c);
-    }
-    if (!line.empty() && line.back() == '\r') line.pop_back();
-    return true;
+// A complete request on a connection the event loop has handed off. The
+// watch cancels it on timeout or hang-up and is released before fd closes.
+struct Job {
+    int fd;
+    Request req;
+    RequestWatcher::Watch watch;
+};
+
+// Per-connection state while the request is still arriving. Lives in the
+// epoll registration (data.ptr) until the request is complete.
+struct Conn {
+    int fd;
+    Metrics::Clock::time_point accepted;
+    std::string in;
+    RequestParser parser;
+};
+
+static void set_blocking(int fd) {
+    int fl = ::fcntl(fd, F_GETFL, 0);
+    if (fl >= 0) ::fcntl(fd, F_SETFL, fl & ~O_NONBLOCK);
 }
 
-// Send string to client
-static bool send_str(int fd, const std::string& s) {
+// Send a short response and close (blocking; responses fit the socket buffer)
+static void reply_and_close(int fd, const std::string& s) {
+    set_blocking(fd);
     const char* p = s.c_str(); size_t left = s.size();
     while (left) {
-        ssize_t w = ::send(fd, p, left, 0);
-        if (w <= 0) return false;
+        ssize_t w = ::send(fd, p, left, MSG_NOSIGNAL);
+        if (w <= 0) break;
         p += w;
         left -= (size_t)w;
     }
-    return true;
+    ::close(fd);
 }
 
-// Handle one client request
-static bool handle_client(int fd) {
-    std::string line;
-    if (!recv_line(fd, line)) return false;
+// Run the request and stream the result back on the (blocking) socket
+static void serve(Job& job, ServerContext& ctx) {
+    ctx.metrics.record_since(kPhaseQueue, job.req.complete_at);
+    bool sent;
+    {
+        FdWriter out(job.fd, /*socket=*/true);
+        execute_request(job.req, ctx, out, job.watch.token());
+        sent = out.flush();
+    }
+    count_cancelled(ctx.metrics, job.watch.token(), sent);
+    job.watch.reset();
+    ::close(job.fd);
+    ctx.metrics.record_since(kPhaseTotal, job.req.complete_at);
+}
 
-    // Expected: ALG <ALGONAME> RAND ...   or   ALG <ALGONAME> FILE ...
-    auto toks = split_ws(line);
-    if (toks.size() < 2 || toks[0] != "ALG") {
-        send_str(fd, "ERR bad request\nEND\n");
-        return true;
+// STATS on the event-loop thread: the reply is built here and sent without
+// blocking. A client that does not take it at once (its receive window is
+// full) loses the rest of it and the connection, rather than stalling every
+// other connection behind it.
+static void answer_stats(Job& job, ServerContext& ctx) {
+    ctx.metrics.record_since(kPhaseQueue, job.req.complete_at);
+    const std::string reply = "OK STATS\n" + ctx.metrics.text() + "\nEND\n";
+    const char* p = reply.data();
+    size_t left = reply.size();
+    while (left) {
+        ssize_t w = ::send(job.fd, p, left, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) break;
+        p += w;
+        left -= (size_t)w;
     }
+    count_cancelled(ctx.metrics, job.watch.token(), left == 0);
+    job.watch.reset();
+    ::close(job.fd);
+    ctx.metrics.record_since(kPhaseTotal, job.req.complete_at);
+}
 
-    std::string alg_name = toks[1];
-    Graph G(0);
+// Answer "busy" for a request no thread could take.
+static void reject_busy(Job& job, Metrics& metrics) {
+    metrics.add(kCountBusy);
+    job.watch.reset();
+    reply_and_close(job.fd, "ERR server busy\nEND\n");
+}
 
-    if (toks[2] == "RAND") {
-        if (toks.size() != 6) {
-            send_str(fd, "ERR RAND usage\nEND\n");
-            return true;
-        }
-        size_t n = std::stoul(toks[3]);
-        size_t m = std::stoul(toks[4]);
-        unsigned seed = (unsigned)std::stoul(toks[5]);
-        try {
-            G = Graph::random_simple(n, m, seed);
-        } catch (const std::exception& e) {
-            send_str(fd, std::string("ERR ") + e.what() + "\nEND\n");
-            return true;
-        }
-    } else if (toks[2] == "FILE") {
-        // Read n m
-        if (!recv_line(fd, line)) {
-            send_str(fd, "ERR missing n m\nEND\n");
-            return true;
-        }
-        auto nm = split_ws(line);
-        if (nm.size() != 2) {
-            send_str(fd, "ERR bad n m\nEND\n");
-            return true;
+static int make_epoll(int listener, std::uint32_t extra) {
+    int ep = ::epoll_create1(EPOLL_CLOEXEC);
+    if (ep < 0) { perror("epoll_create1"); return -1; }
+    epoll_event ev{};
+    ev.events = EPOLLIN | extra;
+    ev.data.ptr = nullptr; // nullptr marks the listener
+    if (::epoll_ctl(ep, EPOLL_CTL_ADD, listener, &ev) < 0) { perror("epoll_ctl"); ::close(ep); return -1; }
+    return ep;
+}
+
+// Accept every pending connection and register it with 'ep'
+static void accept_all(int listener, int ep, std::uint32_t extra, Metrics& metrics) {
+    while (true) {
+        const auto t = Metrics::Clock::now();
+        int c = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (c < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) perror("accept");
+            if (errno == EINTR) continue;
+            return;
         }
-        size_t n = std::stoul(nm[0]);
-        size_t m = std::stoul(nm[1]);
-        G = Graph(n);
-
-        // Read m edges
-        for (size_t i = 0; i < m; ++i) {
-            if (!recv_line(fd, line)) {
-                send_str(fd, "ERR missing edges\nEND\n");
-                return true;
-            }
-            auto uv = split_ws(line);
-            if (uv.size() != 2) {
-                send_str(fd, "ERR bad edge\nEND\n");
-                return true;
-            }
-            size_t u = std::stoul(uv[0]);
-            size_t v = std::stoul(uv[1]);
-            if (!G.add_edge(u, v)) {
-                send_str(fd, "ERR invalid/duplicate edge\nEND\n");
-                return true;
-            }
+        auto* conn = new Conn{c, t, {}, {}};
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP | extra;
+        ev.data.ptr = conn;
+        if (::epoll_ctl(ep, EPOLL_CTL_ADD, c, &ev) < 0) { ::close(c); delete conn; continue; }
+        conn->accepted = metrics.record_since(kPhaseAccept, t);
+        metrics.add(kCountConnections);
+    }
+}
+
+// Read what is available on a registered connection. Returns true once a
+// request is complete: the connection is then unregistered, blocking, and
+// its request is in 'job', already watched (its timeout runs from now).
+// Errors and early EOF are answered and closed here. In both cases 'conn'
+// has been deleted; false with conn still alive means more bytes are needed.
+static bool read_request(int ep, Conn*& conn, std::optional<Job>& job, ServerContext& ctx) {
+    char buf[1 << 16];
+    const int fd = conn->fd;
+    auto finish = [&] {
+        ::epoll_ctl(ep, EPOLL_CTL_DEL, fd, nullptr);
+        delete conn;
+        conn = nullptr;
+    };
+    while (true) {
+        ssize_t r = ::recv(fd, buf, sizeof(buf), 0);
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return false;
+        if (r <= 0) {
+            // Peer finished sending (or failed) before the request was complete
+            std::string err = r == 0 ? conn->parser.eof_error() : std::string();
+            finish();
+            reply_and_close(fd, err);
+            return false;
         }
+        conn->in.append(buf, (size_t)r);
+        auto st = conn->parser.consume(conn->in);
+        if (st == RequestParser::Status::NeedMore) continue;
 
-        // Expect END
-        if (!recv_line(fd, line) || line != "END") {
-            send_str(fd, "ERR expected END\nEND\n");
-            return true;
+        if (st == RequestParser::Status::Error) {
+            ctx.metrics.add(kCountBadRequests);
+            std::string err = conn->parser.error();
+            finish();
+            reply_and_close(fd, err);
+            return false;
         }
-    } else {
-        send_str(fd, "ERR unknown input mode\nEND\n");
+        job.emplace(Job{fd, conn->parser.take(), {}});
+        job->req.complete_at = ctx.metrics.record_since(kPhaseReceive, conn->accepted);
+        ctx.metrics.add(kCountRequests);
+        if (!job->req.pipeline.empty()) ctx.metrics.add(kCountPipe);
+        if (job->req.load) ctx.metrics.add(kCountLoad);
+        if (job->req.stats) ctx.metrics.add(kCountStats);
+        finish();
+        set_blocking(fd);
+        // TIMEOUT can only shorten the server's -T
+        std::size_t ms = job->req.timeout_ms;
+        if (ctx.timeout_ms && (!ms || ms > ctx.timeout_ms)) ms = ctx.timeout_ms;
+        std::optional<std::chrono::milliseconds> timeout;
+        if (ms) timeout = std::chrono::milliseconds(ms);
+        job->watch = ctx.watcher.watch(fd, timeout);
         return true;
     }
+}
 
-    // Create algorithm using Factory
-    GraphAlgorithm* alg = create_algorithm(alg_name);
-    if (!alg) {
-        send_str(fd, "ERR unknown algorithm\nEND\n");
-        return true;
+// Hand a PIPE request to the pipeline, answering "busy" if it is full.
+static void submit_pipe(Pipeline& pipeline, Job& job, Metrics& metrics) {
+    if (!pipeline.try_submit(job.fd, std::move(job.req), std::move(job.watch))) {
+        metrics.add(kCountBusy);
+        reply_and_close(job.fd, "ERR server busy\nEND\n");
     }
+}
 
-    // Run algorithm
-    std::string result = alg->run(G);
-    delete alg;  // avoid leaks
+// Mode "epoll": one thread accepts and reads on non-blocking sockets.
+// Requests are parsed as their bytes arrive; complete ones go to the worker
+// pool, so slow uploads and long algorithms never hold up other connections.
+// STATS is answered on the spot, so it still works when every worker is busy.
+static int run_event_loop(int listener, WorkerPool<Job>& pool, Pipeline& pipeline, ServerContext& ctx) {
+    int ep = make_epoll(listener, 0);
+    if (ep < 0) return 5;
 
-    // If algorithm already prefixed with ERR, send as-is
-    if (result.rfind("ERR", 0) == 0) {
-        send_str(fd, result + "\nEND\n");
-    } else {
-        send_str(fd, result + "\nEND\n");
+    epoll_event events[64];
+    while (true) {
+        int k = ::epoll_wait(ep, events, 64, -1);
+        if (k < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            return 6;
+        }
+        for (int i = 0; i < k; ++i) {
+            auto* conn = static_cast<Conn*>(events[i].data.ptr);
+            if (!conn) { accept_all(listener, ep, 0, ctx.metrics); continue; }
+
+            std::optional<Job> job;
+            if (!read_request(ep, conn, job, ctx)) continue;
+            if (job->req.stats) answer_stats(*job, ctx);
+            else if (!job->req.pipeline.empty()) submit_pipe(pipeline, *job, ctx.metrics);
+            else if (!pool.try_submit(*job)) reject_busy(*job, ctx.metrics);
+        }
     }
-    return true;
+}
+
+// Mode "lf" (Leader/Followers): 'threads' threads share one epoll set whose
+// registrations are EPOLLONESHOT. Holding 'leader' makes a thread the only
+// one waiting for events; as soon as it gets one it hands leadership to a
+// follower and handles the event itself, running a complete request inline.
+// No queue and no handoff between threads (PIPE requests still go to the
+// pipeline's stages).
+static int run_leader_followers(int listener, unsigned threads, Pipeline& pipeline, ServerContext& ctx) {
+    int ep = make_epoll(listener, EPOLLONESHOT);
+    if (ep < 0) return 5;
+
+    std::mutex leader;
+    auto rearm = [ep](int fd, void* ptr, std::uint32_t events) {
+        epoll_event ev{};
+        ev.events = events | EPOLLONESHOT;
+        ev.data.ptr = ptr;
+        ::epoll_ctl(ep, EPOLL_CTL_MOD, fd, &ev);
+    };
+    auto follower = [&] {
+        while (true) {
+            epoll_event ev{};
+            {
+                std::lock_guard<std::mutex> lead(leader);
+                int k;
+                while ((k = ::epoll_wait(ep, &ev, 1, -1)) == 0 || (k < 0 && errno == EINTR)) {}
+                if (k < 0) { perror("epoll_wait"); return; }
+            } // promote the next follower
+
+            auto* conn = static_cast<Conn*>(ev.data.ptr);
+            if (!conn) {
+                accept_all(listener, ep, EPOLLONESHOT, ctx.metrics);
+                rearm(listener, nullptr, EPOLLIN);
+                continue;
+            }
+            std::optional<Job> job;
+            if (read_request(ep, conn, job, ctx)) {
+                if (job->req.pipeline.empty()) serve(*job, ctx);
+                else submit_pipe(pipeline, *job, ctx.metrics);
+            }
+            else if (conn) rearm(conn->fd, conn, EPOLLIN | EPOLLRDHUP);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; ++i) pool.emplace_back(follower);
+    follower();
+    for (auto& t : pool) t.join();
+    return 6;
+}
+
+static void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " <port> [-m epoll|lf] [-w workers] [-q queue] [-t threads] [-s stage-queue]\n"
+                 "       [-M store-MiB] [-C cache-MiB] [-T timeout-ms] [-P metrics-file]\n"
+                 "  -m epoll  One event-loop thread parses requests and queues them for\n"
+                 "            -w worker threads (default mode)\n"
+                 "  -m lf     Leader/Followers: -t threads take turns waiting for events and\n"
+                 "            run each request on the thread that received it\n"
+                 "  -w <num>  Worker threads in epoll mode (default: hardware threads)\n"
+                 "  -q <num>  Max requests waiting for a worker in epoll mode, or for the\n"
+                 "            PIPE pipeline; beyond it clients get \"ERR server busy\"\n"
+                 "            (default 1024)\n"
+                 "  -t <num>  Threads in lf mode (default: hardware threads)\n"
+                 "  -s <num>  Queue between consecutive PIPE stages (default 16)\n"
+                 "  -M <MiB>  Memory for graphs stored by LOAD; the least recently used\n"
+                 "            are evicted beyond it (default 1024)\n"
+                 "  -C <MiB>  Memory for cached results of repeated requests, 0 disables\n"
+                 "            the cache (default 256)\n"
+                 "  -T <ms>   Cancel requests still unanswered this long after they arrived\n"
+                 "            (\"ERR timeout\"); a request's TIMEOUT <ms> may only shorten\n"
+                 "            it (default 0: no limit)\n"
+                 "  -P <file> Where SIGUSR1 writes the metrics (STATS) in Prometheus text\n"
+                 "            format (default alg_server.prom)\n";
 }
 
 int main(int argc, char** argv) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <port>\n";
-        return 1;
+    std::string mode = "epoll";
+    unsigned workers = default_threads(), threads = default_threads();
+    size_t queue = 1024, stage_queue = 16, store_mib = 1024, cache_mib = 256, timeout_ms = 0;
+    std::string metrics_file = "alg_server.prom";
+    int opt;
+    while ((opt = getopt(argc, argv, "m:w:q:t:s:M:C:T:P:h")) != -1) {
+        switch (opt) {
+            case 'm': mode = optarg; break;
+            case 'w': workers = (unsigned)std::strtoul(optarg, nullptr, 10); break;
+            case 'q': queue = std::strtoul(optarg, nullptr, 10); break;
+            case 't': threads = (unsigned)std::strtoul(optarg, nullptr, 10); break;
+            case 's': stage_queue = std::strtoul(optarg, nullptr, 10); break;
+            case 'M': store_mib = std::strtoul(optarg, nullptr, 10); break;
+            case 'C': cache_mib = std::strtoul(optarg, nullptr, 10); break;
+            case 'T': timeout_ms = std::strtoul(optarg, nullptr, 10); break;
+            case 'P': metrics_file = optarg; break;
+            default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
     }
-    int port = std::stoi(argv[1]);
+    if (optind != argc - 1 || (mode != "epoll" && mode != "lf")) { usage(argv[0]); return 1; }
+    if (threads == 0) threads = 1;
+    int port = std::stoi(argv[optind]);
+    std::signal(SIGPIPE, SIG_IGN);
 
-    int s = ::socket(AF_INET, SOCK_STREAM, 0);
+    int s = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (s < 0) { perror("socket"); return 2; }
-    int opt = 1;
-    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    int one = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
 
     sockaddr_in addr{};
     addr.sin_family = AF_INET;
     addr.sin_addr.s_addr = htonl(INADDR_ANY);
     addr.sin_port = htons((uint16_t)port);
     if (::bind(s, (sockaddr*)&addr, sizeof(addr)) < 0) { perror("bind"); return 3; }
-    if (::listen(s, 64) < 0) { perror("listen"); return 4; }
+    if (::listen(s, SOMAXCONN) < 0) { perror("listen"); return 4; }
 
-    std::cout << "Algorithm server listening on port " << port << "...\n";
-    while (true) {
-        int c = ::accept(s, nullptr, nullptr);
-        if (c < 0) { perror("accept"); continue; }
-        handle_client(c);
-        ::close(c);
+    GraphStore store(store_mib << 20);
+    ResultCache cache(cache_mib << 20);
+    auto metrics = make_server_metrics(cache, store);
+    dump_metrics_on_sigusr1(*metrics, metrics_file, "alg_server"); // before any other thread starts
+    RequestWatcher watcher;
+    ServerContext ctx{store, cache, watcher, timeout_ms, *metrics};
+    Pipeline pipeline(queue, stage_queue, ctx);
+    if (mode == "lf") {
+        std::cout << "Algorithm server listening on port " << port << " (leader/followers, " << threads
+                  << " threads)...\n" << std::flush;
+        return run_leader_followers(s, threads, pipeline, ctx);
     }
+    WorkerPool<Job> pool(workers, queue, [&ctx](Job& job) { serve(job, ctx); });
+    std::cout << "Algorithm server listening on port " << port << " (" << workers << " workers)...\n" << std::flush;
+    return run_event_loop(s, pool, pipeline, ctx);
 }
@@ -0,0 +1,62 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+// Read-only name -> object table built at compile time. The constructor
+// searches for a hash seed under which every name gets its own slot (a
+// perfect hash), so find() hashes once, looks at one slot and compares one
+// string. T needs a constexpr name(); duplicate names fail to compile.
+template <typename T, std::size_t N>
+class PerfectHashTable {
+public:
+    // Power of two with at least twice as many slots as names: seeds that
+    // work are common, and the search stays short.
+    static constexpr std::size_t kSlots = [] {
+        std::size_t s = 1;
+        while (s < 2 * N) s *= 2;
+        return s;
+    }();
+
+    constexpr explicit PerfectHashTable(const T* const (&items)[N]) {
+        for (std::size_t i = 0; i < N; ++i)
+            for (std::size_t j = i + 1; j < N; ++j)
+                if (items[i]->name() == items[j]->name()) throw std::logic_error("duplicate name");
+        while (!place(items)) {
+            if (++m_seed == 1u << 16) throw std::logic_error("no perfect hash seed");
+        }
+    }
+
+    // The entry called 'name', or nullptr.
+    constexpr const T* find(std::string_view name) const {
+        const T* t = m_slots[slot(name, m_seed)];
+        return t && t->name() == name ? t : nullptr;
+    }
+
+private:
+    // FNV-1a with the seed folded into the offset basis.
+    static constexpr std::size_t slot(std::string_view s, std::uint32_t seed) {
+        std::uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+        for (char c : s) {
+            h ^= static_cast<unsigned char>(c);
+            h *= 16777619u;
+        }
+        return (h ^ (h >> 16)) & (kSlots - 1);
+    }
+
+    // Fill the slots under m_seed; false on a collision.
+    constexpr bool place(const T* const (&items)[N]) {
+        for (auto& s : m_slots) s = nullptr;
+        for (const T* item : items) {
+            const T*& s = m_slots[slot(item->name(), m_seed)];
+            if (s) return false;
+            s = item;
+        }
+        return true;
+    }
+
+    std::array<const T*, kSlots> m_slots{};
+    std::uint32_t m_seed{0};
+};
@@ -1,201 +1,217 @@
 #include "algorithms.hpp"
+#include "algorithm_registry.hpp"
 #include "euler.hpp"
-#include <sstream>
+#include "max_flow.hpp"
+#include "mst.hpp"
+#include "components.hpp"
+#include "hamilton.hpp"
+#include "parallel.hpp"
+#include "line_reader.hpp"
+#include "../Stage6/server_protocol.hpp"
+#include <iterator>
 #include <vector>
-#include <queue>
 #include <algorithm>
 
+bool GraphAlgorithm::parse(std::string_view opts, AlgorithmArgs&) const { return opts.empty(); }
+
+void GraphAlgorithm::write_binary(const AlgorithmCall& call, FdWriter& out) const {
+    std::string text;
+    append(call, text);
+    write_text_frame(out, cancelled(call.cancel) ? cancel_error(*call.cancel) : text);
+}
+
+bool GraphAlgorithm::write_cancelled(const AlgorithmCall& call, FdWriter& out) {
+    if (!cancelled(call.cancel)) return false;
+    out.put(cancel_error(*call.cancel));
+    return true;
+}
+
+namespace {
+
 // ================= Euler Circuit (reuse Stage2) =================
-class EulerCircuitAlg : public GraphAlgorithm {
+class EulerCircuitAlg final : public GraphAlgorithm {
 public:
-    std::string name() const override { return "EULER"; }
-    std::string run(const Graph& G) override {
-        auto chk = euler_feasibility(G);
-        if (!chk.ok) return "ERR " + chk.reason;
-        auto tour = find_euler_circuit(G);
-        std::ostringstream os;
-        os << "OK CIRCUIT " << (tour.size()-1) << "\n";
-        for (size_t i = 0; i < tour.size(); ++i) {
-            if (i) os << " ";
-            os << tour[i];
+    constexpr EulerCircuitAlg() : GraphAlgorithm("EULER") {}
+
+    void write(const AlgorithmCall& call, FdWriter& out) const override {
+        auto chk = euler_feasibility(call.G);
+        if (!chk.ok) { out.put("ERR " + chk.reason); return; }
+        out.put("OK CIRCUIT ");
+        out.put_uint(call.G.m());
+        out.put('\n');
+        if (!write_circuit(out, call.G, call.cancel) && cancelled(call.cancel)) {
+            out.put('\n');
+            write_cancelled(call, out);
         }
-        return os.str();
+    }
+    void write_binary(const AlgorithmCall& call, FdWriter& out) const override {
+        auto chk = euler_feasibility(call.G);
+        if (!chk.ok) { write_text_frame(out, "ERR " + chk.reason); return; }
+        if (cancelled(call.cancel)) { write_text_frame(out, cancel_error(*call.cancel)); return; }
+        write_circuit_frame(out, call.G, call.cancel);
     }
 };
 
-// ================= MST Weight (Kruskal, weight=1 edges) =================
-class MstWeightAlg : public GraphAlgorithm {
+// ================= MST Weight (Kruskal / parallel Boruvka) =================
+// MST[:EDGES][:KRUSKAL|:BORUVKA]. Boruvka does about three times Kruskal's
+// work per core, so by default it only takes over for large graphs on
+// machines with kParallelMinThreads or more cores. EDGES appends the forest
+// as "u v w" lines.
+class MstWeightAlg final : public GraphAlgorithm {
 public:
-    std::string name() const override { return "MST"; }
-    std::string run(const Graph& G) override {
-        size_t n = G.num_vertices();
-
-        struct Edge { size_t u, v; int w; };
-        std::vector<Edge> edges;
-        for (size_t u = 0; u < n; ++u) {
-            for (size_t v : G.neighbors(u)) {
-                if (u < v) edges.push_back({u, v, 1});
-            }
+    enum Flag : std::uint32_t { kKruskal = 1, kBoruvka = 2, kEdges = 4 };
+    static constexpr size_t kParallelMinEdges = size_t{1} << 20;
+    static constexpr unsigned kParallelMinThreads = 4;
+
+    constexpr MstWeightAlg() : GraphAlgorithm("MST") {}
+
+    bool parse(std::string_view opts, AlgorithmArgs& args) const override {
+        while (!opts.empty()) {
+            opts.remove_prefix(1); // ':'
+            const std::string_view opt = opts.substr(0, opts.find(':'));
+            opts.remove_prefix(opt.size());
+            const std::uint32_t engine = args.flags & (kKruskal | kBoruvka);
+            if (opt == "EDGES" && !(args.flags & kEdges)) args.flags |= kEdges;
+            else if (opt == "KRUSKAL" && !engine) args.flags |= kKruskal;
+            else if (opt == "BORUVKA" && !engine) args.flags |= kBoruvka;
+            else return false;
         }
+        return true;
+    }
 
-        // DSU with size_t
-        std::vector<size_t> p(n);
-        for (size_t i = 0; i < n; i++) p[i] = i;
-
-        auto find = [&](size_t x) {
-            while (p[x] != x) x = p[x];
-            return x;
-        };
-        auto unite = [&](size_t a, size_t b) {
-            a = find(a); b = find(b);
-            if (a != b) p[a] = b;
-        };
-
-        int total = 0;
-        for (auto &e : edges) {
-            if (find(e.u) != find(e.v)) {
-                unite(e.u, e.v);
-                total += e.w;
-            }
+    void write(const AlgorithmCall& call, FdWriter& out) const override {
+        const Graph& G = call.G;
+        const unsigned threads = default_threads();
+        const std::uint32_t flags = call.args.flags;
+        const bool edges = flags & kEdges;
+        const bool parallel = (flags & kBoruvka) || (!(flags & kKruskal) && threads >= kParallelMinThreads &&
+                                                     G.m() >= kParallelMinEdges);
+        MstResult r = parallel ? mst_boruvka(G, threads, edges, call.cancel) : mst_kruskal(G, edges, call.cancel);
+        if (write_cancelled(call, out)) return;
+
+        out.put("OK MST_WEIGHT ");
+        out.put_int(r.total);
+        if (!edges) return;
+        out.put(" EDGES ");
+        out.put_uint(r.edges);
+        for (const MstEdge& e : r.forest) {
+            out.put('\n');
+            out.put_uint(e.u);
+            out.put(' ');
+            out.put_uint(e.v);
+            out.put(' ');
+            out.put_int(e.w);
         }
-
-        std::ostringstream os;
-        os << "OK MST_WEIGHT " << total;
-        return os.str();
     }
 };
 
-// ================= SCC (Kosaraju) =================
-class SccAlg : public GraphAlgorithm {
+// ================= SCC (iterative Tarjan / union-find) =================
+// SCC runs Tarjan; SCC:CC finds the same components of the undirected graph
+// with a parallel union-find, in order of smallest vertex. One line per
+// component, streamed as each one is found.
+class SccAlg final : public GraphAlgorithm {
 public:
-    std::string name() const override { return "SCC"; }
+    static constexpr std::uint32_t kUnionFind = 1;
 
-    void dfs1(const Graph& G, size_t u, std::vector<int>& vis, std::vector<size_t>& order) {
-        vis[u] = 1;
-        for (size_t v : G.neighbors(u)) if (!vis[v]) dfs1(G, v, vis, order);
-        order.push_back(u);
-    }
+    constexpr SccAlg() : GraphAlgorithm("SCC") {}
 
-    void dfs2(const Graph& GT, size_t u, std::vector<int>& vis, std::vector<size_t>& comp) {
-        vis[u] = 1; comp.push_back(u);
-        for (size_t v : GT.neighbors(u)) if (!vis[v]) dfs2(GT, v, vis, comp);
+    bool parse(std::string_view opts, AlgorithmArgs& args) const override {
+        if (opts == ":CC") args.flags |= kUnionFind;
+        return opts.empty() || opts == ":CC";
     }
 
-    std::string run(const Graph& G) override {
-        size_t n = G.num_vertices();
-        std::vector<int> vis(n, 0);
-        std::vector<size_t> order;
-
-        for (size_t i = 0; i < n; i++) if (!vis[i]) dfs1(G, i, vis, order);
-
-        // Build transpose
-        Graph GT(n);
-        for (size_t u = 0; u < n; u++) for (size_t v : G.neighbors(u)) GT.add_edge(v, u);
-
-        std::fill(vis.begin(), vis.end(), 0);
-        std::ostringstream os;
-        os << "OK SCC\n";
-
-        for (int i = (int)order.size() - 1; i >= 0; i--) {
-            size_t u = order[i];
-            if (!vis[u]) {
-                std::vector<size_t> comp;
-                dfs2(GT, u, vis, comp);
-                for (size_t j = 0; j < comp.size(); j++) {
-                    if (j) os << " ";
-                    os << comp[j];
-                }
-                os << "\n";
+    void write(const AlgorithmCall& call, FdWriter& out) const override {
+        out.put("OK SCC\n");
+        const ComponentSink sink = [&](const vertex_t* vs, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                if (i) out.put(' ');
+                out.put_uint(vs[i]);
             }
-        }
-        return os.str();
+            out.put('\n');
+            return out.ok();
+        };
+        const bool done = call.args.flags & kUnionFind ? for_each_component(call.G, sink, default_threads(), call.cancel)
+                                                       : for_each_scc(call.G, sink, call.cancel);
+        if (!done) write_cancelled(call, out);
     }
 };
 
-// ================= Max Flow (Edmonds-Karp, capacity=1) =================
-class MaxFlowAlg : public GraphAlgorithm {
+// ================= Max Flow (Dinic, capacity=edge weight) =================
+// MAXFLOW runs from 0 to n-1, MAXFLOW:s:t between the given vertices.
+class MaxFlowAlg final : public GraphAlgorithm {
 public:
-    std::string name() const override { return "MAXFLOW"; }
-    std::string run(const Graph& G) override {
-        size_t n = G.num_vertices();
-        std::vector<std::vector<int>> cap(n, std::vector<int>(n, 0));
-
-        for (size_t u = 0; u < n; u++) 
-            for (size_t v : G.neighbors(u)) 
-                cap[u][v] = 1;
-
-        int s = 0, t = (int)n - 1;
-        int flow = 0;
-
-        while (true) {
-            std::vector<int> par(n, -1);
-            std::queue<int> q; q.push(s); par[s] = s;
-            while (!q.empty() && par[t] == -1) {
-                int u = q.front(); q.pop();
-                for (int v = 0; v < (int)n; v++) if (par[v] == -1 && cap[u][v] > 0) {
-                    par[v] = u; q.push(v);
-                }
-            }
-            if (par[t] == -1) break;
+    static constexpr std::uint32_t kEnds = 1; // s, t given as args.a, args.b
 
-            int aug = 1e9;
-            for (int v = t; v != s; v = par[v]) aug = std::min(aug, cap[par[v]][v]);
-            for (int v = t; v != s; v = par[v]) {
-                cap[par[v]][v] -= aug;
-                cap[v][par[v]] += aug;
-            }
-            flow += aug;
-        }
+    constexpr MaxFlowAlg() : GraphAlgorithm("MAXFLOW") {}
 
-        std::ostringstream os;
-        os << "OK MAXFLOW " << flow;
-        return os.str();
+    bool parse(std::string_view opts, AlgorithmArgs& args) const override {
+        if (opts.empty()) return true;
+        opts.remove_prefix(1); // ':'
+        const size_t colon = opts.find(':');
+        if (colon == std::string_view::npos || !parse_size(opts.substr(0, colon), args.a) ||
+            !parse_size(opts.substr(colon + 1), args.b))
+            return false;
+        args.flags |= kEnds;
+        return true;
     }
-};
-
-// ================= Hamiltonian Circuit (backtracking) =================
-class HamiltonAlg : public GraphAlgorithm {
-public:
-    std::string name() const override { return "HAMILTON"; }
 
-    bool dfs(const Graph& G, std::vector<int>& path, std::vector<int>& used, int n) {
-        if ((int)path.size() == n) {
-            int u = path.back(), v = path.front();
-            for (size_t x : G.neighbors(u)) if ((int)x == v) return true;
-            return false;
-        }
-        int u = path.back();
-        for (size_t v : G.neighbors(u)) {
-            if (!used[v]) {
-                used[v] = 1; path.push_back((int)v);
-                if (dfs(G, path, used, n)) return true;
-                path.pop_back(); used[v] = 0;
-            }
-        }
-        return false;
+    void write(const AlgorithmCall& call, FdWriter& out) const override {
+        const size_t n = call.G.num_vertices();
+        const bool ends = call.args.flags & kEnds;
+        const size_t s = ends ? call.args.a : 0, t = ends ? call.args.b : n - 1;
+        if (n < 2) { out.put("ERR MAXFLOW needs at least 2 vertices"); return; }
+        if (s >= n || t >= n) { out.put("ERR MAXFLOW source/sink out of range"); return; }
+        if (s == t) { out.put("ERR MAXFLOW source equals sink"); return; }
+        const weight_t flow = max_flow(call.G, s, t, call.cancel);
+        if (write_cancelled(call, out)) return;
+        out.put("OK MAXFLOW ");
+        out.put_int(flow);
     }
+};
 
-    std::string run(const Graph& G) override {
-        int n = (int)G.num_vertices();
-        std::vector<int> used(n, 0), path;
-        path.push_back(0); used[0] = 1;
-        if (dfs(G, path, used, n)) {
-            std::ostringstream os;
-            os << "OK HAMILTON ";
-            for (size_t i = 0; i < path.size(); i++) { if (i) os << " "; os << path[i]; }
-            os << " " << path[0];
-            return os.str();
+// ================= Hamiltonian Circuit (Held-Karp / pruned search) =================
+class HamiltonAlg final : public GraphAlgorithm {
+public:
+    constexpr HamiltonAlg() : GraphAlgorithm("HAMILTON") {}
+
+    void write(const AlgorithmCall& call, FdWriter& out) const override {
+        const std::vector<vertex_t> cycle = hamilton_cycle(call.G, default_threads(), call.cancel);
+        if (write_cancelled(call, out)) return;
+        if (cycle.empty()) { out.put("ERR No Hamiltonian cycle"); return; }
+        out.put("OK HAMILTON");
+        for (vertex_t v : cycle) {
+            out.put(' ');
+            out.put_uint(v);
         }
-        return "ERR No Hamiltonian cycle";
     }
 };
 
-// ================= Factory =================
-GraphAlgorithm* create_algorithm(const std::string& alg_name) {
-    if (alg_name == "EULER") return new EulerCircuitAlg();
-    if (alg_name == "MST") return new MstWeightAlg();
-    if (alg_name == "SCC") return new SccAlg();
-    if (alg_name == "MAXFLOW") return new MaxFlowAlg();
-    if (alg_name == "HAMILTON") return new HamiltonAlg();
-    return nullptr;
+// ================= Registry =================
+// Every algorithm the server offers. A new one is a class above plus its
+// instance in this list; lookup needs no other change. The list is explicit
+// on purpose: the perfect hash is computed at compile time, so it needs the
+// full set in one place, and registration from static initializers would
+// bring back run-time setup and initialization-order dependencies.
+constexpr EulerCircuitAlg kEuler;
+constexpr MstWeightAlg kMst;
+constexpr SccAlg kScc;
+constexpr MaxFlowAlg kMaxFlow;
+constexpr HamiltonAlg kHamilton;
+
+constexpr const GraphAlgorithm* kAlgorithms[] = {&kEuler, &kMst, &kScc, &kMaxFlow, &kHamilton};
+constexpr PerfectHashTable<GraphAlgorithm, std::size(kAlgorithms)> kRegistry(kAlgorithms);
+
+} // namespace
+
+const GraphAlgorithm* find_algorithm(std::string_view spec, AlgorithmArgs& args) {
+    const std::string_view base = spec.substr(0, spec.find(':'));
+    const GraphAlgorithm* alg = kRegistry.find(base);
+    args = AlgorithmArgs{};
+    return alg && alg->parse(spec.substr(base.size()), args) ? alg : nullptr;
+}
+
+std::vector<std::string_view> algorithm_names() {
+    std::vector<std::string_view> names;
+    for (const GraphAlgorithm* alg : kAlgorithms) names.push_back(alg->name());
+    return names;
 }
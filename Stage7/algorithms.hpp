@@ -1,10 +1,78 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
 #include "../Stage1/graph.hpp"
+#include "../Stage1/fd_writer.hpp"
+#include "../Stage1/cancel.hpp"
+#include "../Stage6/binary_protocol.hpp"
+
+// Reply text for a request whose token fired: "ERR timeout" or "ERR cancelled".
+inline std::string cancel_error(const CancelToken& token) {
+    return token.reason() == CancelToken::Reason::Timeout ? "ERR timeout" : "ERR cancelled";
+}
+
+// Options from the text after an algorithm's name ("MAXFLOW:2:7" -> a = 2,
+// b = 7); what they mean is up to the algorithm that parsed them.
+struct AlgorithmArgs {
+    std::uint32_t flags{0};
+    std::size_t a{0}, b{0};
+};
 
-struct GraphAlgorithm {
-    virtual std::string name() const = 0;
-    virtual std::string run(const Graph& G) = 0;
-    virtual ~GraphAlgorithm() = default;
+// One run: the graph, the parsed options and the request's cancel token
+// (nullptr: never cancelled).
+struct AlgorithmCall {
+    const Graph& G;
+    AlgorithmArgs args;
+    const CancelToken* cancel{nullptr};
 };
 
-GraphAlgorithm* create_algorithm(const std::string& alg_name);
+// Algorithms are stateless constexpr singletons listed in the registry at
+// the end of algorithms.cpp; every request shares them and brings its own
+// state in an AlgorithmCall.
+class GraphAlgorithm {
+public:
+    constexpr std::string_view name() const { return m_name; }
+
+    // Parse the options after the name, "" or ":opt:..."; false if malformed.
+    // The default takes none.
+    virtual bool parse(std::string_view opts, AlgorithmArgs& args) const;
+    // Write the result, "OK ..." or "ERR ...", without the trailing END.
+    // Large results are written as they are found. Once the call's token
+    // fires the result is cancel_error(); one already partly written ends
+    // with it as its last line.
+    virtual void write(const AlgorithmCall& call, FdWriter& out) const = 0;
+    // Write the result as one frame of the binary protocol (TEXT by default).
+    virtual void write_binary(const AlgorithmCall& call, FdWriter& out) const;
+
+    // write() appended to 'out', for results that are kept (result cache).
+    void append(const AlgorithmCall& call, std::string& out) const {
+        FdWriter w(out);
+        write(call, w);
+    }
+
+protected:
+    constexpr explicit GraphAlgorithm(std::string_view name) : m_name(name) {}
+    ~GraphAlgorithm() = default; // singletons: never deleted through the base
+
+    // Writes cancel_error() and returns true if the call's token fired.
+    static bool write_cancelled(const AlgorithmCall& call, FdWriter& out);
+
+private:
+    std::string_view m_name;
+};
+
+// The registered algorithm named by 'spec', "NAME" or "NAME:options" (e.g.
+// "MAXFLOW:0:9"), with its options parsed into 'args'; nullptr for an
+// unknown name or malformed options. A perfect-hash lookup in a table built
+// at compile time: no allocation and a single string compare.
+const GraphAlgorithm* find_algorithm(std::string_view spec, AlgorithmArgs& args);
+
+// Names of all registered algorithms, in registry order.
+std::vector<std::string_view> algorithm_names();
+
+// The name without its arguments ("MAXFLOW:0:9" -> "MAXFLOW").
+inline std::string algorithm_base(const std::string& alg_name) { return alg_name.substr(0, alg_name.find(':')); }
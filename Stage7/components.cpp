@@ -0,0 +1,99 @@
+#include "components.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "parallel.hpp"
+
+bool for_each_scc(const Graph& G, const ComponentSink& sink, const CancelToken* cancel) {
+    constexpr vertex_t kUnvisited = std::numeric_limits<vertex_t>::max();
+    const std::size_t n = G.n();
+    std::vector<vertex_t> index(n, kUnvisited), low(n);
+    std::vector<char> on_stack(n, 0);
+    std::vector<vertex_t> stack; // Tarjan's stack: open components, in discovery order
+
+    struct Frame {
+        vertex_t v;
+        std::size_t next; // next position in neighbors(v)
+    };
+    std::vector<Frame> calls;
+    vertex_t counter = 0;
+    CancelPoll poll(cancel);
+
+    auto visit = [&](std::size_t v) {
+        index[v] = low[v] = counter++;
+        stack.push_back(static_cast<vertex_t>(v));
+        on_stack[v] = 1;
+        calls.push_back({static_cast<vertex_t>(v), 0});
+    };
+
+    for (std::size_t root = 0; root < n; ++root) {
+        if (index[root] != kUnvisited) continue;
+        visit(root);
+        while (!calls.empty()) {
+            if (poll()) return false;
+            Frame& f = calls.back();
+            const vertex_t v = f.v;
+            const auto nbrs = G.neighbors(v);
+            if (f.next < nbrs.size()) {
+                const vertex_t w = nbrs[f.next++];
+                if (index[w] == kUnvisited) visit(w); // invalidates f
+                else if (on_stack[w]) low[v] = std::min(low[v], index[w]);
+                continue;
+            }
+            calls.pop_back();
+            if (low[v] == index[v]) {
+                // v roots a component: everything above it on the stack
+                std::size_t from = stack.size();
+                while (stack[--from] != v) {
+                }
+                for (std::size_t i = from; i < stack.size(); ++i) on_stack[stack[i]] = 0;
+                if (!sink(stack.data() + from, stack.size() - from)) return false;
+                stack.resize(from);
+            }
+            if (!calls.empty()) {
+                const vertex_t parent = calls.back().v;
+                low[parent] = std::min(low[parent], low[v]);
+            }
+        }
+    }
+    return true;
+}
+
+bool for_each_component(const Graph& G, const ComponentSink& sink, unsigned threads,
+                        const CancelToken* cancel) {
+    const std::size_t n = G.n();
+    ConcurrentDsu<vertex_t> dsu(n);
+    parallel_for(n, threads, [&](std::size_t lo, std::size_t hi) {
+        if (cancelled(cancel)) return;
+        for (std::size_t u = lo; u < hi; ++u)
+            for (vertex_t v : G.neighbors(u))
+                if (v > u) dsu.unite(static_cast<vertex_t>(u), v);
+    });
+    if (cancelled(cancel)) return false;
+
+    // Bucket the vertices by root (counting sort; a scan in vertex order
+    // keeps every bucket ascending)
+    std::vector<vertex_t> root(n);
+    parallel_for(n, threads, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t v = lo; v < hi; ++v) root[v] = dsu.find(static_cast<vertex_t>(v));
+    }, 1u << 14);
+    std::vector<std::size_t> start(n + 1, 0);
+    for (std::size_t v = 0; v < n; ++v) ++start[root[v] + 1];
+    for (std::size_t v = 0; v < n; ++v) start[v + 1] += start[v];
+    std::vector<vertex_t> order(n);
+    {
+        std::vector<std::size_t> at(start.begin(), start.end() - 1);
+        for (std::size_t v = 0; v < n; ++v) order[at[root[v]]++] = static_cast<vertex_t>(v);
+    }
+
+    // Roots are the smallest vertex of their set, so root order is the
+    // order of first vertices
+    CancelPoll poll(cancel);
+    for (std::size_t r = 0; r < n; ++r) {
+        if (poll()) return false;
+        if (start[r + 1] > start[r] && !sink(order.data() + start[r], start[r + 1] - start[r])) return false;
+    }
+    return true;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+
+#include "graph.hpp"
+#include "cancel.hpp"
+
+// Receives one component per call: its vertices, contiguous. Returning
+// false stops the enumeration (e.g. the client went away).
+using ComponentSink = std::function<bool(const vertex_t* vertices, std::size_t count)>;
+
+// Strongly connected components, treating every adjacency entry u -> v as a
+// directed arc (for the undirected Graph both directions exist, so these
+// are its connected components). Iterative Tarjan with an explicit call
+// stack: no recursion depth limit, no transpose, O(n + m) time and O(n)
+// scratch. Each component goes to the sink as soon as it is complete, in
+// DFS discovery order, straight from Tarjan's stack. Returns false if the
+// sink stopped early or 'cancel' fired.
+bool for_each_scc(const Graph& G, const ComponentSink& sink, const CancelToken* cancel = nullptr);
+
+// Connected components of the undirected graph with 'threads' workers:
+// edges are united in parallel in a ConcurrentDsu, whose roots are the
+// smallest vertex of each set. Components are then emitted in order of
+// their smallest vertex, vertices ascending. O(n) scratch.
+bool for_each_component(const Graph& G, const ComponentSink& sink, unsigned threads,
+                        const CancelToken* cancel = nullptr);
@@ -0,0 +1,34 @@
+#include "graph_store.hpp"
+
+#include <utility>
+
+std::optional<std::uint64_t> GraphStore::put(std::shared_ptr<const Graph> G) {
+    const std::size_t bytes = G->memory_bytes();
+    if (bytes > m_budget) return std::nullopt;
+
+    std::lock_guard<std::mutex> lock(m_mu);
+    while (m_used + bytes > m_budget) {
+        const Entry& victim = m_lru.back();
+        m_used -= victim.bytes;
+        m_index.erase(victim.id);
+        m_lru.pop_back();
+    }
+    const std::uint64_t id = m_next_id++;
+    m_lru.push_front(Entry{id, std::move(G), bytes});
+    m_index.emplace(id, m_lru.begin());
+    m_used += bytes;
+    return id;
+}
+
+std::shared_ptr<const Graph> GraphStore::get(std::uint64_t id) {
+    std::lock_guard<std::mutex> lock(m_mu);
+    auto it = m_index.find(id);
+    if (it == m_index.end()) return nullptr;
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    return it->second->graph;
+}
+
+GraphStore::Usage GraphStore::usage() const {
+    std::lock_guard<std::mutex> lock(m_mu);
+    return Usage{m_lru.size(), m_used};
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+#include "graph.hpp"
+
+// Graphs kept in server memory under numeric handles (LOAD, then
+// ALG <NAME> HANDLE <id>). Stored graphs are immutable and handed out as
+// shared_ptr<const Graph>: the lock only covers the lookup, so any number of
+// requests run on the same graph at once, and a graph evicted while in use
+// lives until its last reader finishes.
+// The total Graph::memory_bytes() of stored graphs stays within 'budget';
+// storing a new graph evicts the least recently used ones.
+class GraphStore {
+public:
+    explicit GraphStore(std::size_t budget_bytes) : m_budget(budget_bytes) {}
+
+    GraphStore(const GraphStore&) = delete;
+    GraphStore& operator=(const GraphStore&) = delete;
+
+    // Store G and return its handle; nullopt if G alone exceeds the budget.
+    std::optional<std::uint64_t> put(std::shared_ptr<const Graph> G);
+
+    // The graph stored under 'id' (now the most recently used), or nullptr.
+    std::shared_ptr<const Graph> get(std::uint64_t id);
+
+    struct Usage {
+        std::size_t graphs, bytes;
+    };
+    // Graphs stored and their total memory.
+    Usage usage() const;
+
+private:
+    struct Entry {
+        std::uint64_t id;
+        std::shared_ptr<const Graph> graph;
+        std::size_t bytes;
+    };
+
+    mutable std::mutex m_mu;
+    std::list<Entry> m_lru; // front = most recently used
+    std::unordered_map<std::uint64_t, std::list<Entry>::iterator> m_index;
+    std::size_t m_budget;
+    std::size_t m_used{0};
+    std::uint64_t m_next_id{1};
+};
@@ -0,0 +1,505 @@
+#include "hamilton.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+
+#include "parallel.hpp"
+
+namespace {
+
+constexpr vertex_t kNone = std::numeric_limits<vertex_t>::max();
+
+// Small graphs try this many search steps before falling back to Held-Karp,
+// which costs the same on every graph of a given size (~100 ms at n = 24)
+// while the search usually settles a random graph in well under a
+// millisecond.
+constexpr std::size_t kSmallSearchSteps = std::size_t{1} << 16;
+
+// Larger graphs first try Posa's heuristic with this much work per vertex
+// and adjacency entry; it finds a cycle in most random graphs that have
+// one long before the exact search would.
+constexpr std::size_t kPosaWorkPerEntry = 32;
+constexpr std::size_t kPosaMinWork = std::size_t{1} << 18;
+
+// The exact search restarts with a new tie-break order after this many
+// steps per branch, doubling each time, kRestarts times.
+constexpr std::size_t kRestartSteps = std::size_t{1} << 10;
+constexpr std::uint64_t kRestarts = 24;
+
+// Above kBitsetMaxVertices the per-step connectivity check walks the
+// adjacency lists, O(n + m); past this n + 2m it is skipped altogether.
+constexpr std::size_t kListCheckMaxSize = std::size_t{1} << 20;
+
+// ---- O(n + m) necessary conditions ----
+
+// True if G is connected and has no cut vertex (iterative lowpoint DFS from
+// 0). A Hamiltonian cycle survives the removal of any one vertex as a path,
+// so a graph with a cut vertex has none.
+bool biconnected(const Graph& G) {
+    const std::size_t n = G.n();
+    std::vector<vertex_t> disc(n, kNone), low(n), parent(n, kNone);
+    struct Frame {
+        vertex_t v;
+        std::size_t next; // next position in neighbors(v)
+    };
+    std::vector<Frame> calls{{0, 0}};
+    vertex_t counter = 0;
+    std::size_t root_children = 0;
+    disc[0] = low[0] = counter++;
+
+    while (!calls.empty()) {
+        Frame& f = calls.back();
+        const vertex_t v = f.v;
+        const auto nbrs = G.neighbors(v);
+        if (f.next < nbrs.size()) {
+            const vertex_t w = nbrs[f.next++];
+            if (disc[w] == kNone) {
+                if (v == 0) ++root_children;
+                parent[w] = v;
+                disc[w] = low[w] = counter++;
+                calls.push_back({w, 0}); // invalidates f
+            } else if (w != parent[v]) {
+                low[v] = std::min(low[v], disc[w]);
+            }
+            continue;
+        }
+        calls.pop_back();
+        if (calls.empty()) break;
+        const vertex_t p = calls.back().v;
+        low[p] = std::min(low[p], low[v]);
+        if (p != 0 && low[v] >= disc[p]) return false;
+    }
+    return counter == n && root_children <= 1;
+}
+
+// False if G is bipartite with sides of different size: a cycle alternates
+// sides, so it covers both equally.
+bool balanced_if_bipartite(const Graph& G) {
+    const std::size_t n = G.n();
+    std::vector<signed char> side(n, -1);
+    std::vector<vertex_t> queue;
+    queue.reserve(n);
+    std::size_t count[2] = {0, 0};
+    for (std::size_t root = 0; root < n; ++root) {
+        if (side[root] >= 0) continue;
+        side[root] = 0;
+        ++count[0];
+        queue.assign(1, static_cast<vertex_t>(root));
+        for (std::size_t head = 0; head < queue.size(); ++head) {
+            const vertex_t u = queue[head];
+            for (vertex_t v : G.neighbors(u)) {
+                if (side[v] == side[u]) return true; // odd cycle
+                if (side[v] < 0) {
+                    side[v] = static_cast<signed char>(1 - side[u]);
+                    ++count[side[v]];
+                    queue.push_back(v);
+                }
+            }
+        }
+    }
+    return count[0] == count[1];
+}
+
+// ---- Held-Karp ----
+
+// ends[mask] holds every v such that some path from 0 visits exactly
+// {0} + mask and stops at v; vertex i >= 1 is bit i-1 of mask, ends are
+// plain vertex bits.
+std::vector<vertex_t> held_karp(const Graph& G, const CancelToken* cancel) {
+    const std::size_t n = G.n();
+    std::vector<std::uint32_t> adj(n, 0);
+    for (std::size_t u = 0; u < n; ++u)
+        for (vertex_t v : G.neighbors(u)) adj[u] |= std::uint32_t{1} << v;
+
+    const std::uint32_t full = (std::uint32_t{1} << (n - 1)) - 1;
+    std::vector<std::uint32_t> ends(std::size_t{full} + 1, 0);
+    ends[0] = 1;
+    CancelPoll poll(cancel);
+    for (std::uint32_t mask = 0; mask < full; ++mask) {
+        if (poll()) return {};
+        const std::uint32_t e = ends[mask];
+        if (!e) continue;
+        for (std::uint32_t rest = full & ~mask; rest; rest &= rest - 1) {
+            const unsigned b = static_cast<unsigned>(__builtin_ctz(rest));
+            if (adj[b + 1] & e) ends[mask | (std::uint32_t{1} << b)] |= std::uint32_t{1} << (b + 1);
+        }
+    }
+
+    const std::uint32_t last = ends[full] & adj[0];
+    if (!last) return {};
+    // Walk back from a closing end; the tour comes out reversed, which is
+    // still a cycle through 0
+    std::vector<vertex_t> tour{0};
+    std::uint32_t mask = full;
+    vertex_t v = static_cast<vertex_t>(__builtin_ctz(last));
+    while (v != 0) {
+        tour.push_back(v);
+        mask ^= std::uint32_t{1} << (v - 1);
+        v = static_cast<vertex_t>(__builtin_ctz(ends[mask] & adj[v]));
+    }
+    tour.push_back(0);
+    return tour;
+}
+
+// splitmix64 finalizer: a cheap, seedable tie-break order.
+std::uint64_t scramble(std::uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+// ---- Posa rotation-extension ----
+
+// Grows a path from 0, always to the unvisited neighbor of the end with the
+// fewest unvisited neighbors. When the end has none (or the path is full but
+// does not close), a neighbor p[i] of the end rotates the path: p[i+1..end]
+// is reversed, so p[i+1] becomes the new end. The pivot is one whose p[i+1]
+// can extend (or, on a full path, is adjacent to 0), nearest the end; if
+// there is none, a random one. Gives up, with an empty result, once 'work'
+// adjacency entries and moved path slots are spent.
+std::vector<vertex_t> posa(const Graph& G, std::size_t work, const CancelToken* cancel) {
+    const std::size_t n = G.n();
+    std::vector<vertex_t> path{0}, pos(n, kNone), free_deg(n);
+    path.reserve(n);
+    pos[0] = 0;
+    for (std::size_t v = 0; v < n; ++v) free_deg[v] = static_cast<vertex_t>(G.degree(v));
+    std::vector<char> near_start(n, 0);
+    for (vertex_t x : G.neighbors(0)) {
+        --free_deg[x];
+        near_start[x] = 1;
+    }
+    std::uint64_t rng = 0x9e3779b97f4a7c15ull ^ n; // xorshift64; fixed seed keeps replies stable
+
+    CancelPoll poll(cancel);
+    while (true) {
+        if (poll()) return {};
+        const vertex_t end = path.back();
+        const auto nbrs = G.neighbors(end);
+        if (work < nbrs.size()) return {};
+        work -= nbrs.size();
+
+        vertex_t next = kNone;
+        bool closes = false;
+        for (vertex_t x : nbrs) {
+            closes = closes || x == path[0];
+            if (pos[x] == kNone && (next == kNone || free_deg[x] < free_deg[next])) next = x;
+        }
+        if (next != kNone) {
+            pos[next] = static_cast<vertex_t>(path.size());
+            path.push_back(next);
+            for (vertex_t x : G.neighbors(next)) --free_deg[x];
+            continue;
+        }
+        const bool full = path.size() == n;
+        if (full && closes) break;
+
+        const std::size_t k = path.size() - 1;
+        std::size_t i = kNone;
+        for (vertex_t x : nbrs) {
+            const std::size_t j = pos[x];
+            if (j + 1 >= k || (i != kNone && j < i)) continue;
+            const vertex_t e = path[j + 1];
+            if (full ? near_start[e] : free_deg[e] > 0) i = j;
+        }
+        if (i == kNone) {
+            rng ^= rng << 13;
+            rng ^= rng >> 7;
+            rng ^= rng << 17;
+            i = pos[nbrs[rng % nbrs.size()]];
+            if (i + 1 == k) continue; // the end's predecessor: nothing to rotate
+        }
+        if (work < k - i) return {};
+        work -= k - i;
+        std::reverse(path.begin() + static_cast<std::ptrdiff_t>(i + 1), path.end());
+        for (std::size_t j = i + 1; j <= k; ++j) pos[path[j]] = static_cast<vertex_t>(j);
+    }
+    path.push_back(0);
+    return path;
+}
+
+// ---- Branch search ----
+
+// Row-per-vertex adjacency bits, shared read-only by all branches.
+struct BitAdjacency {
+    std::size_t words = 0;
+    std::vector<std::uint64_t> bits;
+
+    explicit BitAdjacency(const Graph& G) : words((G.n() + 63) / 64), bits(G.n() * words, 0) {
+        for (std::size_t u = 0; u < G.n(); ++u)
+            for (vertex_t v : G.neighbors(u)) bits[u * words + v / 64] |= std::uint64_t{1} << (v % 64);
+    }
+    const std::uint64_t* row(vertex_t v) const { return bits.data() + std::size_t{v} * words; }
+};
+
+// One branch: the path s -> first[branch] -> ... that may only close over
+// an edge to a later first[] neighbor (a cycle whose two edges at s are
+// first[i] and first[j], i < j, belongs to branch i). Vertices are
+// "available" while they can still gain a path edge: unvisited ones, the
+// head and s. avail[v] counts v's available neighbors over usable edges.
+// With a step budget the search gives up once it is spent; 'seed' breaks
+// ties between equally constrained candidates, so restarts differ.
+class BranchSearch {
+public:
+    BranchSearch(const Graph& G, const BitAdjacency* bits, vertex_t s, const std::vector<vertex_t>& first,
+                 std::size_t branch, const std::atomic<bool>& stop, const CancelToken* cancel, std::size_t budget,
+                 std::uint64_t seed)
+        : m_G(G), m_bits(bits), m_s(s), m_stop(stop), m_cancel(cancel), m_budget(budget), m_seed(seed),
+          m_in_path(G.n(), 0),
+          m_closing(G.n(), 0), m_avail(G.n(), 0) {
+        for (std::size_t j = branch + 1; j < first.size(); ++j) m_closing[first[j]] = 1;
+        const vertex_t a = first[branch];
+        m_path = {s, a};
+        m_in_path[s] = m_in_path[a] = 1;
+        m_remaining = G.n() - 2;
+        m_check_lists = !m_bits && G.n() + 2 * G.m() <= kListCheckMaxSize;
+        if (m_check_lists) m_seen.assign(G.n(), 0);
+        if (m_bits) {
+            m_unvisited.assign(m_bits->words, 0);
+            for (std::size_t v = 0; v < G.n(); ++v)
+                if (!m_in_path[v]) m_unvisited[v / 64] |= std::uint64_t{1} << (v % 64);
+        }
+        for (std::size_t v = 0; v < G.n(); ++v) {
+            if (m_in_path[v] && v != s && v != a) continue;
+            for (vertex_t x : G.neighbors(v))
+                if (usable(static_cast<vertex_t>(v), x) && (!m_in_path[x] || x == s || x == a)) ++m_avail[v];
+        }
+    }
+
+    // The cycle (n vertices, without the repeated s), or empty.
+    std::vector<vertex_t> run() {
+        const vertex_t a = m_path[1];
+        for (std::size_t v = 0; v < m_G.n(); ++v)
+            if (!m_in_path[v] && m_avail[v] < 2) return {};
+        if (m_avail[m_s] < 1) return {};
+        if (!connected(a)) return {};
+
+        struct Frame {
+            vertex_t head;
+            std::size_t base, next, end; // candidate range in m_cands
+        };
+        std::vector<Frame> frames;
+        push_frame(frames, a);
+        while (!frames.empty()) {
+            if (m_stop.load(std::memory_order_relaxed) || m_cancel()) return {};
+            Frame& f = frames.back();
+            if (f.next == f.end) {
+                // Exhausted: step back to the previous head
+                m_cands.resize(f.base);
+                frames.pop_back();
+                if (!frames.empty()) unmove(frames.back().head);
+                continue;
+            }
+            if (m_budget && m_budget-- == 1) {
+                m_gave_up = true;
+                return {};
+            }
+            const vertex_t h = f.head;
+            const vertex_t w = m_cands[f.next++];
+            if (!move(h, w)) {
+                unmove(h);
+                continue;
+            }
+            if (m_remaining == 0) return m_path;
+            push_frame(frames, w); // invalidates f
+        }
+        return {};
+    }
+
+    // True if run() stopped on the step budget rather than deciding.
+    bool gave_up() const { return m_gave_up; }
+
+private:
+    bool usable(vertex_t v, vertex_t x) const { return (x != m_s || m_closing[v]) && (v != m_s || m_closing[x]); }
+
+    // Candidates for the step after head h, fewest options first; a
+    // neighbor with only two available neighbors left must come next.
+    template <typename Frames>
+    void push_frame(Frames& frames, vertex_t h) {
+        const std::size_t begin = m_cands.size();
+        vertex_t forced = kNone;
+        std::size_t forced_count = 0;
+        for (vertex_t x : m_G.neighbors(h)) {
+            if (m_in_path[x]) continue;
+            if (m_avail[x] == 2) {
+                forced = x;
+                ++forced_count;
+            }
+            m_cands.push_back(x);
+        }
+        if (forced_count > 1) {
+            m_cands.resize(begin);
+        } else if (forced_count == 1) {
+            m_cands.resize(begin);
+            m_cands.push_back(forced);
+        } else {
+            auto fewer_options = [&](vertex_t x, vertex_t y) {
+                if (m_avail[x] != m_avail[y]) return m_avail[x] < m_avail[y];
+                return scramble(x ^ m_seed) < scramble(y ^ m_seed);
+            };
+            std::sort(m_cands.begin() + static_cast<std::ptrdiff_t>(begin), m_cands.end(), fewer_options);
+        }
+        frames.push_back({h, begin, begin, m_cands.size()});
+    }
+
+    // Extend the path h -> w. False if that leaves an unvisited vertex (or
+    // s) without enough available neighbors, cuts the unvisited part off the
+    // head, or completes a path that cannot close; the caller then undoes
+    // the step with unmove(h).
+    bool move(vertex_t h, vertex_t w) {
+        for (vertex_t x : m_G.neighbors(h))
+            if (usable(h, x)) --m_avail[x];
+        m_in_path[w] = 1;
+        m_path.push_back(w);
+        --m_remaining;
+        if (m_bits) m_unvisited[w / 64] &= ~(std::uint64_t{1} << (w % 64));
+        if (m_remaining == 0) return m_closing[w];
+
+        for (vertex_t x : m_G.neighbors(h)) {
+            if (!usable(h, x)) continue;
+            if (!m_in_path[x] && m_avail[x] < 2) return false;
+            if (x == m_s && m_avail[x] < 1) return false;
+        }
+        return connected(w);
+    }
+
+    // Undo the last step, whose previous head was h.
+    void unmove(vertex_t h) {
+        const vertex_t w = m_path.back();
+        m_path.pop_back();
+        m_in_path[w] = 0;
+        ++m_remaining;
+        if (m_bits) m_unvisited[w / 64] |= std::uint64_t{1} << (w % 64);
+        for (vertex_t x : m_G.neighbors(h))
+            if (usable(h, x)) ++m_avail[x];
+    }
+
+    // Every unvisited vertex and s reachable from 'head' through unvisited
+    // vertices: BFS over bitset rows, or over the adjacency lists for graphs
+    // too big for bitsets. Graphs past kListCheckMaxSize skip the check.
+    bool connected(vertex_t head) {
+        if (!m_bits) return m_check_lists ? connected_lists(head) : true;
+        const std::size_t words = m_bits->words;
+        m_left.assign(m_unvisited.begin(), m_unvisited.end());
+        m_queue.assign(1, head);
+        bool reached_s = false;
+        for (std::size_t i = 0; i < m_queue.size(); ++i) {
+            const std::uint64_t* row = m_bits->row(m_queue[i]);
+            reached_s = reached_s || (row[m_s / 64] >> (m_s % 64) & 1);
+            for (std::size_t k = 0; k < words; ++k) {
+                for (std::uint64_t hit = row[k] & m_left[k]; hit; hit &= hit - 1)
+                    m_queue.push_back(static_cast<vertex_t>(k * 64 + static_cast<unsigned>(__builtin_ctzll(hit))));
+                m_left[k] &= ~row[k];
+            }
+        }
+        if (!reached_s) return false;
+        for (std::size_t k = 0; k < words; ++k)
+            if (m_left[k]) return false;
+        return true;
+    }
+
+    bool connected_lists(vertex_t head) {
+        if (++m_stamp == 0) {
+            std::fill(m_seen.begin(), m_seen.end(), 0);
+            m_stamp = 1;
+        }
+        m_queue.assign(1, head);
+        m_seen[head] = m_stamp;
+        bool reached_s = false;
+        for (std::size_t i = 0; i < m_queue.size(); ++i) {
+            for (vertex_t x : m_G.neighbors(m_queue[i])) {
+                reached_s = reached_s || x == m_s;
+                if (m_in_path[x] || m_seen[x] == m_stamp) continue;
+                m_seen[x] = m_stamp;
+                m_queue.push_back(x);
+            }
+        }
+        return reached_s && m_queue.size() == m_remaining + 1;
+    }
+
+    const Graph& m_G;
+    const BitAdjacency* m_bits;
+    const vertex_t m_s;
+    const std::atomic<bool>& m_stop;
+    CancelPoll m_cancel;
+    std::size_t m_budget; // steps left; 0 means unlimited
+    const std::uint64_t m_seed;
+    bool m_gave_up = false;
+
+    std::vector<char> m_in_path, m_closing;
+    std::vector<vertex_t> m_avail, m_path, m_cands, m_queue;
+    std::vector<std::uint64_t> m_unvisited, m_left;
+    std::size_t m_remaining = 0;
+    bool m_check_lists = false;
+    std::vector<std::uint32_t> m_seen; // BFS marks, == m_stamp when seen
+    std::uint32_t m_stamp = 0;
+};
+
+// One pass of the branch search over the first edges at the lowest-degree
+// vertex, each branch limited to 'budget' steps (0: unlimited). *decided is
+// false if a branch ran out before a cycle turned up.
+std::vector<vertex_t> search(const Graph& G, const BitAdjacency* bits, unsigned threads, std::size_t budget,
+                             std::uint64_t seed, const CancelToken* cancel, bool* decided) {
+    const std::size_t n = G.n();
+    vertex_t s = 0;
+    for (std::size_t v = 1; v < n; ++v)
+        if (G.degree(v) < G.degree(s)) s = static_cast<vertex_t>(v);
+    const auto nbrs = G.neighbors(s);
+    std::vector<vertex_t> first(nbrs.begin(), nbrs.end());
+    std::sort(first.begin(), first.end(), [&](vertex_t x, vertex_t y) {
+        if (G.degree(x) != G.degree(y)) return G.degree(x) < G.degree(y);
+        return scramble(x ^ seed) < scramble(y ^ seed);
+    });
+
+    std::atomic<bool> found{false}, gave_up{false};
+    std::mutex mu;
+    std::vector<vertex_t> cycle;
+    parallel_for(first.size() - 1, threads, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t b = lo; b < hi && !found.load(std::memory_order_relaxed); ++b) {
+            BranchSearch branch(G, bits, s, first, b, found, cancel, budget, seed);
+            std::vector<vertex_t> c = branch.run();
+            if (branch.gave_up()) gave_up = true;
+            if (c.empty()) continue;
+            std::lock_guard<std::mutex> lock(mu);
+            if (!found.exchange(true)) cycle = std::move(c);
+        }
+    }, 1);
+    *decided = !cycle.empty() || !gave_up;
+    if (cycle.empty()) return {};
+
+    // Report it from vertex 0
+    std::rotate(cycle.begin(), std::find(cycle.begin(), cycle.end(), vertex_t{0}), cycle.end());
+    cycle.push_back(0);
+    return cycle;
+}
+
+} // namespace
+
+std::vector<vertex_t> hamilton_cycle(const Graph& G, unsigned threads, const CancelToken* cancel) {
+    const std::size_t n = G.n();
+    if (n < 3) return {};
+    for (std::size_t v = 0; v < n; ++v)
+        if (G.degree(v) < 2) return {};
+    if (!biconnected(G) || !balanced_if_bipartite(G)) return {};
+
+    std::unique_ptr<BitAdjacency> bits;
+    if (n <= kBitsetMaxVertices) bits = std::make_unique<BitAdjacency>(G);
+    bool decided = false;
+    if (n <= kHeldKarpMaxVertices) {
+        std::vector<vertex_t> cycle = search(G, bits.get(), 1, kSmallSearchSteps, 0, cancel, &decided);
+        return decided || cancelled(cancel) ? cycle : held_karp(G, cancel);
+    }
+    std::vector<vertex_t> cycle = posa(G, std::max(kPosaMinWork, kPosaWorkPerEntry * (n + 2 * G.m())), cancel);
+    if (!cycle.empty() || cancelled(cancel)) return cycle;
+
+    // Restarts with doubling budgets: a bad early choice only costs one
+    // pass, and the last pass runs without limit
+    for (std::uint64_t pass = 0;; ++pass) {
+        const std::size_t budget = pass < kRestarts ? kRestartSteps << pass : 0;
+        cycle = search(G, bits.get(), threads, budget, pass, cancel, &decided);
+        if (decided || cancelled(cancel)) return cycle;
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+#include "graph.hpp"
+#include "cancel.hpp"
+
+// Graphs up to this size are decided exactly by Held-Karp: O(2^n * n) word
+// operations and 4 * 2^(n-1) bytes (32 MiB at the limit).
+constexpr std::size_t kHeldKarpMaxVertices = 24;
+
+// Up to this size the branch search keeps bitset adjacency for its
+// per-step check that the unvisited vertices are still reachable (larger
+// graphs walk the adjacency lists instead).
+constexpr std::size_t kBitsetMaxVertices = 2048;
+
+// Hamiltonian cycle of G as n+1 vertices starting and ending at 0; empty if
+// there is none. Steps:
+//  1. O(n + m) necessary conditions: n >= 3, minimum degree 2, connected,
+//     no cut vertex, and equal sides if G is bipartite.
+//  2. n <= kHeldKarpMaxVertices: the exact search of step 3 on one thread
+//     with a small step budget, then, if that did not settle it, Held-Karp
+//     over bitmasks of the vertices visited after 0, with the possible path ends
+//     as a bitmask per subset.
+//  3. Larger graphs: Posa's rotation-extension heuristic with a work budget
+//     linear in n + m, then, if it found nothing, an exact depth-first search
+//     from a lowest-degree vertex, without recursion: a vertex left with
+//     fewer than two usable neighbors ends the branch, one left with exactly
+//     two forces the next step, candidates are tried fewest-options first,
+//     and the unvisited part must stay connected to the path's head. Each
+//     first edge is a branch; branches run on 'threads' workers and the first
+//     cycle found stops the others. The search restarts with a new tie-break
+//     order and a doubled step budget while a branch runs out, so one early
+//     mistake cannot trap it; it is still exponential in the worst case.
+// Every phase polls 'cancel'; once it fires the result is empty and means
+// nothing.
+std::vector<vertex_t> hamilton_cycle(const Graph& G, unsigned threads = 1, const CancelToken* cancel = nullptr);
@@ -0,0 +1,125 @@
+#include "max_flow.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace {
+
+class Dinic {
+public:
+    Dinic(const Graph& G, const CancelToken* cancel)
+        : m_cancel(cancel), m_off(G.csr_offsets().data()), m_head(G.csr_neighbors().data()), m_n(G.n()),
+          m_cap(2 * G.m()), m_rev(2 * G.m()), m_level(G.n()), m_it(G.n()) {
+        // Pair the two slots of every edge id; each starts with the edge's
+        // full capacity (undirected: either direction may carry it).
+        const auto eids = G.csr_edge_ids();
+        std::vector<std::size_t> first(G.m(), kNone);
+        for (std::size_t p = 0; p < eids.size(); ++p) {
+            const std::size_t e = eids[p];
+            m_cap[p] = G.weight(e);
+            if (first[e] == kNone) {
+                first[e] = p;
+            } else {
+                m_rev[p] = first[e];
+                m_rev[first[e]] = p;
+            }
+        }
+    }
+
+    weight_t run(std::size_t s, std::size_t t) {
+        weight_t flow = 0;
+        while (!cancelled(m_cancel) && bfs(s, t)) {
+            for (std::size_t u = 0; u < m_n; ++u) m_it[u] = m_off[u];
+            flow += blocking_flow(s, t);
+        }
+        return flow;
+    }
+
+private:
+    static constexpr std::size_t kNone = std::numeric_limits<std::size_t>::max();
+
+    // Level graph from s; true if t is reachable.
+    bool bfs(std::size_t s, std::size_t t) {
+        std::fill(m_level.begin(), m_level.end(), -1);
+        m_queue.clear();
+        m_queue.push_back(s);
+        m_level[s] = 0;
+        for (std::size_t i = 0; i < m_queue.size() && m_level[t] < 0; ++i) {
+            const std::size_t u = m_queue[i];
+            for (std::size_t p = m_off[u]; p < m_off[u + 1]; ++p) {
+                const std::size_t v = m_head[p];
+                if (m_cap[p] > 0 && m_level[v] < 0) {
+                    m_level[v] = m_level[u] + 1;
+                    m_queue.push_back(v);
+                }
+            }
+        }
+        return m_level[t] >= 0;
+    }
+
+    // Augment along level-increasing paths until none is left. The path is
+    // an explicit stack of slots (no recursion on long paths); the tail of
+    // slot p is the head of its reverse.
+    weight_t blocking_flow(std::size_t s, std::size_t t) {
+        weight_t flow = 0;
+        m_path.clear();
+        std::size_t u = s;
+        CancelPoll poll(m_cancel);
+        while (true) {
+            if (poll()) return flow;
+            if (u == t) {
+                weight_t push = std::numeric_limits<weight_t>::max();
+                for (std::size_t p : m_path) push = std::min(push, m_cap[p]);
+                std::size_t keep = m_path.size();
+                for (std::size_t i = 0; i < m_path.size(); ++i) {
+                    const std::size_t p = m_path[i];
+                    m_cap[p] -= push;
+                    m_cap[m_rev[p]] += push;
+                    if (m_cap[p] == 0 && keep == m_path.size()) keep = i;
+                }
+                flow += push;
+                // Resume from the tail of the first saturated arc
+                m_path.resize(keep);
+                u = keep ? m_head[m_path.back()] : s;
+                continue;
+            }
+            std::size_t& p = m_it[u];
+            while (p < m_off[u + 1] && (m_cap[p] == 0 || m_level[m_head[p]] != m_level[u] + 1)) ++p;
+            if (p < m_off[u + 1]) {
+                m_path.push_back(p);
+                u = m_head[p];
+                continue;
+            }
+            // Dead end: drop u from the level graph and retreat
+            m_level[u] = -1;
+            if (m_path.empty()) return flow;
+            const std::size_t back = m_path.back();
+            m_path.pop_back();
+            u = m_head[m_rev[back]];
+            ++m_it[u];
+        }
+    }
+
+    const CancelToken* m_cancel;
+    const std::size_t* m_off;
+    const vertex_t* m_head;
+    std::size_t m_n;
+    std::vector<weight_t> m_cap;     // residual capacity per CSR slot
+    std::vector<std::size_t> m_rev;  // slot of the opposite direction
+    std::vector<long> m_level;
+    std::vector<std::size_t> m_it;   // current arc per vertex
+    std::vector<std::size_t> m_queue;
+    std::vector<std::size_t> m_path; // slots from s to the current vertex
+};
+
+} // namespace
+
+weight_t max_flow(const Graph& G, std::size_t s, std::size_t t, const CancelToken* cancel) {
+    if (!G.frozen()) {
+        Graph copy(G);
+        copy.finalize();
+        return max_flow(copy, s, t, cancel);
+    }
+    return Dinic(G, cancel).run(s, t);
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+
+#include "graph.hpp"
+#include "cancel.hpp"
+
+// Maximum s-t flow of the undirected graph G, where edge e carries up to
+// G.weight(e) units in either direction (1 for an unweighted graph).
+// Dinic's algorithm on a residual graph laid over G's CSR slots: the two
+// slots of an edge are each other's reverse arc, so the residual state is
+// one capacity per slot plus O(n) level / current-arc arrays, O(n + m)
+// memory in all. BFS builds the level graph, then an iterative DFS with
+// current-arc pointers finds a blocking flow; O(V^2 E) worst case and far
+// less on sparse graphs. s and t must be distinct vertices of G; an
+// unfinalized G is copied and finalized first. 'cancel' is polled between
+// phases and every few thousand DFS steps; the flow found so far is
+// returned when it fires.
+weight_t max_flow(const Graph& G, std::size_t s, std::size_t t, const CancelToken* cancel = nullptr);
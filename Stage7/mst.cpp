@@ -0,0 +1,269 @@
+#include "mst.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+#include "parallel.hpp"
+
+namespace {
+
+struct WeightedEdge {
+    weight_t w;
+    vertex_t u, v;
+};
+
+// Each edge once (u < v), in CSR order; filled in parallel per vertex.
+std::vector<WeightedEdge> edge_array(const Graph& G, unsigned threads) {
+    const std::size_t n = G.n();
+    std::vector<std::size_t> start(n + 1, 0);
+    parallel_for(n, threads, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t u = lo; u < hi; ++u)
+            for (std::size_t v : G.neighbors(u)) start[u + 1] += v > u;
+    });
+    for (std::size_t u = 0; u < n; ++u) start[u + 1] += start[u];
+
+    std::vector<WeightedEdge> edges(start[n]);
+    parallel_for(n, threads, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t u = lo; u < hi; ++u) {
+            const auto nbrs = G.neighbors(u);
+            const auto eids = G.edge_ids(u);
+            std::size_t at = start[u];
+            for (std::size_t i = 0; i < nbrs.size(); ++i)
+                if (nbrs[i] > u) edges[at++] = {G.weight(eids[i]), static_cast<vertex_t>(u), nbrs[i]};
+        }
+    });
+    return edges;
+}
+
+// Signed weights in unsigned order.
+inline std::uint64_t sort_key(weight_t w) { return static_cast<std::uint64_t>(w) ^ (std::uint64_t{1} << 63); }
+
+// Stable LSD radix sort by weight; bytes equal in every key are skipped.
+void radix_sort_by_weight(std::vector<WeightedEdge>& edges) {
+    if (edges.empty()) return;
+    const std::uint64_t first = sort_key(edges[0].w);
+    std::uint64_t differ = 0;
+    for (const auto& e : edges) differ |= sort_key(e.w) ^ first;
+    if (differ == 0) return;
+
+    std::vector<WeightedEdge> tmp(edges.size());
+    for (unsigned shift = 0; shift < 64; shift += 8) {
+        if (((differ >> shift) & 0xffU) == 0) continue;
+        std::size_t count[257] = {};
+        for (const auto& e : edges) ++count[((sort_key(e.w) >> shift) & 0xffU) + 1];
+        for (std::size_t i = 0; i < 256; ++i) count[i + 1] += count[i];
+        for (const auto& e : edges) tmp[count[(sort_key(e.w) >> shift) & 0xffU]++] = e;
+        edges.swap(tmp);
+    }
+}
+
+// Serial union-find: union by size, path halving.
+class Dsu {
+public:
+    explicit Dsu(std::size_t n) : m_parent(n), m_size(n, 1) {
+        for (std::size_t i = 0; i < n; ++i) m_parent[i] = static_cast<vertex_t>(i);
+    }
+
+    vertex_t find(vertex_t x) {
+        while (m_parent[x] != x) x = m_parent[x] = m_parent[m_parent[x]];
+        return x;
+    }
+
+    bool unite(vertex_t a, vertex_t b) {
+        a = find(a);
+        b = find(b);
+        if (a == b) return false;
+        if (m_size[a] < m_size[b]) std::swap(a, b);
+        m_parent[b] = a;
+        m_size[a] += m_size[b];
+        return true;
+    }
+
+private:
+    std::vector<vertex_t> m_parent;
+    std::vector<vertex_t> m_size;
+};
+
+// Boruvka's working edge: endpoints as component labels (a, b) plus the
+// original edge for the forest.
+struct ContractedEdge {
+    weight_t w;
+    vertex_t a, b;
+    vertex_t u, v;
+};
+
+// Relabel the endpoints with 'label' and keep the edges that still join two
+// components, in order. Blocks are counted, then scattered, in parallel.
+void contract(std::vector<ContractedEdge>& edges, std::vector<ContractedEdge>& scratch,
+              const std::vector<vertex_t>& label, unsigned threads) {
+    const std::size_t blocks = std::max<std::size_t>(1, std::min<std::size_t>(edges.size() / 4096, 8 * threads));
+    const std::size_t per = (edges.size() + blocks - 1) / blocks;
+    auto range = [&](std::size_t b) {
+        return std::make_pair(std::min(edges.size(), b * per), std::min(edges.size(), (b + 1) * per));
+    };
+    std::vector<std::size_t> start(blocks + 1, 0);
+    parallel_for(blocks, threads, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t b = lo; b < hi; ++b) {
+            auto [first, last] = range(b);
+            for (std::size_t i = first; i < last; ++i) start[b + 1] += label[edges[i].a] != label[edges[i].b];
+        }
+    }, 1);
+    for (std::size_t b = 0; b < blocks; ++b) start[b + 1] += start[b];
+
+    scratch.resize(start[blocks]);
+    parallel_for(blocks, threads, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t b = lo; b < hi; ++b) {
+            auto [first, last] = range(b);
+            std::size_t at = start[b];
+            for (std::size_t i = first; i < last; ++i) {
+                const ContractedEdge& e = edges[i];
+                const vertex_t a = label[e.a], c = label[e.b];
+                if (a != c) scratch[at++] = {e.w, a, c, e.u, e.v};
+            }
+        }
+    }, 1);
+    edges.swap(scratch);
+}
+
+// Number the DSU roots among 0..k-1 consecutively and map every element
+// to its root's number; returns the number of roots.
+std::size_t relabel(ConcurrentDsu<vertex_t>& dsu, std::size_t k, std::vector<vertex_t>& label, unsigned threads) {
+    std::size_t next = 0;
+    for (std::size_t c = 0; c < k; ++c)
+        if (dsu.find(static_cast<vertex_t>(c)) == c) label[c] = static_cast<vertex_t>(next++);
+    parallel_for(k, threads, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t c = lo; c < hi; ++c) label[c] = label[dsu.find(static_cast<vertex_t>(c))];
+    }, 1u << 14);
+    return next;
+}
+
+} // namespace
+
+MstResult mst_kruskal(const Graph& G, bool want_forest, const CancelToken* cancel) {
+    MstResult r;
+    if (G.n() < 2) return r;
+    std::vector<WeightedEdge> edges = edge_array(G, 1);
+    if (G.weighted()) radix_sort_by_weight(edges); // otherwise any order is minimal
+
+    Dsu dsu(G.n());
+    CancelPoll poll(cancel);
+    for (const auto& e : edges) {
+        if (poll()) break;
+        if (!dsu.unite(e.u, e.v)) continue;
+        r.total += e.w;
+        if (want_forest) r.forest.push_back({e.u, e.v, e.w});
+        if (++r.edges == G.n() - 1) break;
+    }
+    return r;
+}
+
+MstResult mst_boruvka(const Graph& G, unsigned threads, bool want_forest, const CancelToken* cancel) {
+    constexpr std::size_t kNone = std::numeric_limits<std::size_t>::max();
+    MstResult r;
+    const std::size_t n = G.n();
+    if (n < 2) return r;
+    if (!G.frozen()) {
+        Graph copy(G);
+        copy.finalize();
+        return mst_boruvka(copy, threads, want_forest, cancel);
+    }
+    auto take = [&](vertex_t u, vertex_t v, weight_t w) {
+        r.total += w;
+        ++r.edges;
+        if (want_forest) r.forest.push_back({u, v, w});
+    };
+
+    // Round 1 straight from the adjacency: every vertex scans its own edges
+    // for the lightest one (ties broken by edge id), no atomics needed
+    std::vector<vertex_t> label(n);
+    std::size_t k = 0; // components; labels are 0..k-1
+    {
+        ConcurrentDsu<vertex_t> dsu(n);
+        std::vector<std::size_t> joined(n, kNone); // slot of the pick, if it merged two trees
+        const auto offsets = G.csr_offsets();
+        const auto nbrs = G.csr_neighbors();
+        const auto eids = G.csr_edge_ids();
+        parallel_for(n, threads, [&](std::size_t lo, std::size_t hi) {
+            for (std::size_t u = lo; u < hi; ++u) {
+                std::size_t pick = kNone;
+                for (std::size_t p = offsets[u]; p < offsets[u + 1]; ++p) {
+                    if (pick == kNone || G.weight(eids[p]) < G.weight(eids[pick]) ||
+                        (G.weight(eids[p]) == G.weight(eids[pick]) && eids[p] < eids[pick]))
+                        pick = p;
+                }
+                if (pick != kNone && dsu.unite(static_cast<vertex_t>(u), nbrs[pick])) joined[u] = pick;
+            }
+        }, 1u << 12);
+        for (std::size_t u = 0; u < n; ++u) {
+            if (joined[u] == kNone) continue;
+            const vertex_t v = nbrs[joined[u]];
+            take(std::min(static_cast<vertex_t>(u), v), std::max(static_cast<vertex_t>(u), v), G.weight(eids[joined[u]]));
+        }
+        k = relabel(dsu, n, label, threads);
+    }
+
+    // Remaining edges between different components, in contracted form
+    std::vector<ContractedEdge> edges, scratch;
+    {
+        std::vector<std::size_t> start(n + 1, 0);
+        parallel_for(n, threads, [&](std::size_t lo, std::size_t hi) {
+            for (std::size_t u = lo; u < hi; ++u)
+                for (std::size_t v : G.neighbors(u)) start[u + 1] += v > u && label[v] != label[u];
+        });
+        for (std::size_t u = 0; u < n; ++u) start[u + 1] += start[u];
+        edges.resize(start[n]);
+        parallel_for(n, threads, [&](std::size_t lo, std::size_t hi) {
+            for (std::size_t u = lo; u < hi; ++u) {
+                const auto nbrs = G.neighbors(u);
+                const auto eids = G.edge_ids(u);
+                std::size_t at = start[u];
+                for (std::size_t i = 0; i < nbrs.size(); ++i) {
+                    const vertex_t v = nbrs[i];
+                    if (v > u && label[v] != label[u])
+                        edges[at++] = {G.weight(eids[i]), label[u], label[v], static_cast<vertex_t>(u), v};
+                }
+            }
+        });
+    }
+    std::vector<std::atomic<std::size_t>> best(k); // lightest outgoing edge per label
+    std::vector<std::size_t> joined(k);            // the pick, if it merged two trees
+
+    while (!edges.empty() && !cancelled(cancel)) {
+        parallel_for(k, threads, [&](std::size_t lo, std::size_t hi) {
+            for (std::size_t c = lo; c < hi; ++c) best[c].store(kNone, std::memory_order_relaxed);
+        }, 1u << 16);
+
+        // Edge positions break weight ties, a strict order for this round
+        auto lighter = [&](std::size_t x, std::size_t y) {
+            return edges[x].w < edges[y].w || (edges[x].w == edges[y].w && x < y);
+        };
+        parallel_for(edges.size(), threads, [&](std::size_t lo, std::size_t hi) {
+            for (std::size_t i = lo; i < hi; ++i) {
+                for (vertex_t c : {edges[i].a, edges[i].b}) {
+                    std::size_t cur = best[c].load(std::memory_order_relaxed);
+                    while ((cur == kNone || lighter(i, cur)) &&
+                           !best[c].compare_exchange_weak(cur, i, std::memory_order_relaxed)) {
+                    }
+                }
+            }
+        });
+
+        // An edge picked by both of its components merges them once
+        ConcurrentDsu<vertex_t> dsu(k);
+        parallel_for(k, threads, [&](std::size_t lo, std::size_t hi) {
+            for (std::size_t c = lo; c < hi; ++c) {
+                const std::size_t i = best[c].load(std::memory_order_relaxed);
+                joined[c] = i != kNone && dsu.unite(edges[i].a, edges[i].b) ? i : kNone;
+            }
+        }, 1u << 14);
+        for (std::size_t c = 0; c < k; ++c)
+            if (joined[c] != kNone) take(edges[joined[c]].u, edges[joined[c]].v, edges[joined[c]].w);
+
+        k = relabel(dsu, k, label, threads);
+        contract(edges, scratch, label, threads);
+    }
+    return r;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+#include "graph.hpp"
+#include "cancel.hpp"
+
+// Minimum spanning forest of G under G.weight() (every edge weighs 1 in an
+// unweighted graph). Both engines give the same total; with equal weights
+// the chosen edges may differ. When 'cancel' fires they stop early and
+// return a partial forest.
+struct MstEdge {
+    vertex_t u, v; // u < v
+    weight_t w;
+};
+
+struct MstResult {
+    weight_t total{0};
+    std::size_t edges{0};       // n minus the number of components
+    std::vector<MstEdge> forest; // only filled when asked for
+};
+
+// Kruskal: the edges are LSD radix-sorted by weight, one byte per pass and
+// only over the bytes in which weights differ (no sort at all for an
+// unweighted graph), then merged with a union-find using union by size and
+// path halving. Stops once the forest is complete.
+MstResult mst_kruskal(const Graph& G, bool want_forest, const CancelToken* cancel = nullptr);
+
+// Boruvka rounds with 'threads' workers. Round one scans each vertex's own
+// adjacency for its lightest edge; later rounds work on a contracted edge
+// list (endpoints renamed to component labels 0..k-1, internal edges
+// dropped), where every component picks its lightest outgoing edge with a
+// CAS (ties broken by position, so the picks cannot close a cycle). Picks
+// are merged through a ConcurrentDsu. At most log2(n) rounds.
+MstResult mst_boruvka(const Graph& G, unsigned threads, bool want_forest,
+                      const CancelToken* cancel = nullptr);
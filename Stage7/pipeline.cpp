@@ -0,0 +1,132 @@
+#include "pipeline.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include "algorithms.hpp"
+#include "server_metrics.hpp"
+
+// Algorithm stages, in chain order
+static const char* const kStageAlgs[] = {"EULER", "MST", "SCC", "MAXFLOW", "HAMILTON"};
+
+struct PipeJob {
+    int fd;
+    Request req;
+    RequestWatcher::Watch watch;      // released before fd is closed
+    std::shared_ptr<const Graph> graph;
+    std::vector<std::string> results; // parallel to req.pipeline
+    std::string cache_key;            // empty: bypass the result cache
+    std::string error;                // set: skip the algorithms and reply with it
+
+    // Turns a fired token into the reply; true if the job is cancelled.
+    bool check_cancel() {
+        const CancelToken* token = watch.token();
+        if (!cancelled(token)) return false;
+        if (error.empty()) error = cancel_error(*token) + "\nEND\n";
+        return true;
+    }
+};
+
+Pipeline::Pipeline(std::size_t capacity, std::size_t stage_capacity, ServerContext& ctx) {
+    const std::size_t algs = std::size(kStageAlgs);
+    m_stages.reserve(algs + 2);
+    // Jobs only arrive after the constructor returns, so every handler
+    // finds its successor in m_stages.
+    auto forward = [this](std::size_t next, std::unique_ptr<PipeJob>& job) {
+        m_stages[next]->submit(std::move(job));
+    };
+
+    m_stages.push_back(std::make_unique<Stage>(1, capacity, [forward, &ctx](std::unique_ptr<PipeJob>& job) {
+        const auto t = ctx.metrics.record_since(kPhaseQueue, job->req.complete_at);
+        for (const auto& name : job->req.pipeline) {
+            AlgorithmArgs args;
+            if (!find_algorithm(name, args) || std::find(std::begin(kStageAlgs), std::end(kStageAlgs), algorithm_base(name)) == std::end(kStageAlgs)) {
+                job->error = "ERR unknown algorithm " + name + "\nEND\n";
+                break;
+            }
+        }
+        if (job->error.empty() && !job->check_cancel()) {
+            job->graph = build_graph(job->req, ctx.store, job->error);
+            ctx.metrics.record_since(kPhaseBuild, t);
+            if (job->graph && !job->check_cancel()) job->cache_key = result_cache_key(job->req, ctx.cache, job->graph.get());
+            job->results.resize(job->req.pipeline.size());
+        }
+        forward(1, job);
+    }));
+
+    for (std::size_t s = 0; s < algs; ++s) {
+        m_stages.push_back(std::make_unique<Stage>(1, stage_capacity, [forward, s, &ctx](std::unique_ptr<PipeJob>& job) {
+            if (job->error.empty() && !job->check_cancel()) {
+                const auto& names = job->req.pipeline;
+                for (std::size_t i = 0; i < names.size(); ++i) {
+                    if (algorithm_base(names[i]) != kStageAlgs[s]) continue;
+                    // Names may carry arguments (MAXFLOW:s:t), parsed per name
+                    AlgorithmArgs args;
+                    const GraphAlgorithm* alg = find_algorithm(names[i], args);
+                    const AlgorithmCall call{*job->graph, args, job->watch.token()};
+                    auto run = [&] {
+                        const auto t = Metrics::Clock::now();
+                        alg->append(call, job->results[i]);
+                        ctx.metrics.record_since(algorithm_phase(*alg), t);
+                    };
+                    // A name listed twice is computed once
+                    auto first = std::find(names.begin(), names.end(), names[i]) - names.begin();
+                    if (first < static_cast<std::ptrdiff_t>(i)) {
+                        job->results[i] = job->results[first];
+                    } else if (job->cache_key.empty()) {
+                        run();
+                    } else if (auto hit = ctx.cache.get(names[i], job->cache_key)) {
+                        job->results[i] = *hit;
+                    } else {
+                        run();
+                        if (!job->check_cancel()) ctx.cache.put(names[i], job->cache_key, job->results[i]);
+                    }
+                    if (job->check_cancel()) break;
+                }
+            }
+            forward(s + 2, job);
+        }));
+    }
+
+    m_stages.push_back(std::make_unique<Stage>(1, stage_capacity, [&ctx](std::unique_ptr<PipeJob>& job) {
+        const auto t = Metrics::Clock::now();
+        bool sent;
+        {
+            FdWriter out(job->fd, /*socket=*/true);
+            if (!job->error.empty()) {
+                out.put(job->error);
+            } else {
+                out.put("OK PIPE ");
+                out.put_uint(job->results.size());
+                out.put('\n');
+                for (const auto& r : job->results) {
+                    out.put(r);
+                    out.put("\nEND\n");
+                }
+            }
+            sent = out.flush();
+        }
+        count_cancelled(ctx.metrics, job->watch.token(), sent);
+        job->watch.reset();
+        ::close(job->fd);
+        const auto done = ctx.metrics.record_since(kPhaseSend, t);
+        ctx.metrics.record(kPhaseTotal, done - job->req.complete_at);
+    }));
+}
+
+// Shut down front to back: each stage drains into the next before that one
+// is closed, so every accepted job is still answered.
+Pipeline::~Pipeline() {
+    for (auto& stage : m_stages) stage.reset();
+}
+
+bool Pipeline::try_submit(int fd, Request&& req, RequestWatcher::Watch watch) {
+    auto job = std::make_unique<PipeJob>();
+    job->fd = fd;
+    job->req = std::move(req);
+    job->watch = std::move(watch);
+    return m_stages.front()->try_submit(job);
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "request.hpp"
+#include "request_watcher.hpp"
+#include "worker_pool.hpp"
+
+struct PipeJob;
+
+// Executes PIPE requests on a chain of active objects, each a single thread
+// with its own bounded queue:
+//   BUILD -> EULER -> MST -> SCC -> MAXFLOW -> HAMILTON -> REPLY
+// BUILD builds or generates the graph, every algorithm stage runs its
+// algorithm if the request names it, and REPLY writes the combined response
+// and closes the connection. Different requests occupy different stages at
+// the same time. Handing a job to the next stage blocks while that queue is
+// full, so a slow stage stalls the stages before it instead of letting its
+// queue grow. BUILD's queue holds up to 'capacity' waiting requests; once
+// it is full try_submit() fails. The other queues hold 'stage_capacity'.
+//
+// Response: "OK PIPE <k>\n" followed by one "<result>\nEND\n" block per
+// requested algorithm, in request order. Errors before any algorithm runs
+// (bad graph, unknown name) are a single "ERR ...\nEND\n", and so is a
+// request whose token fires before its last algorithm finishes: each stage
+// checks it, so a cancelled job passes through the rest untouched.
+class Pipeline {
+public:
+    // 'ctx' must outlive the pipeline.
+    Pipeline(std::size_t capacity, std::size_t stage_capacity, ServerContext& ctx);
+    ~Pipeline();
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    // Queue the request read from 'fd'; the pipeline owns the connection and
+    // its watch from then on. Returns false if the first stage is full (the
+    // watch is released by then).
+    bool try_submit(int fd, Request&& req, RequestWatcher::Watch watch);
+
+private:
+    using Stage = WorkerPool<std::unique_ptr<PipeJob>>;
+
+    std::vector<std::unique_ptr<Stage>> m_stages;
+};
@@ -0,0 +1,361 @@
+#include "request.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <vector>
+
+#include "../Stage6/binary_protocol.hpp"
+#include "../Stage6/server_protocol.hpp"
+#include "algorithms.hpp"
+#include "server_metrics.hpp"
+#include "line_reader.hpp"
+
+namespace {
+
+std::vector<std::string_view> split_view(std::string_view s) {
+    std::vector<std::string_view> out;
+    for (auto f = next_field(s); !f.empty(); f = next_field(s)) out.push_back(f);
+    return out;
+}
+
+// Exactly two numbers separated by blanks ("u v", "n m").
+bool parse_pair(std::string_view line, std::size_t& a, std::size_t& b) {
+    std::size_t v[2];
+    if (!parse_fields(line, v, 2)) return false;
+    a = v[0];
+    b = v[1];
+    return true;
+}
+
+} // namespace
+
+RequestParser::Status RequestParser::fail(std::string msg) {
+    m_error = "ERR " + msg + "\nEND\n";
+    if (m_req.binary) m_error = text_frame(m_error);
+    m_state = State::Finished;
+    return Status::Error;
+}
+
+RequestParser::Status RequestParser::consume(std::string& in) {
+    std::size_t pos = 0;
+    Status st = Status::NeedMore;
+    while (st == Status::NeedMore) {
+        if (m_state == State::BinHeader || m_state == State::BinEdges) {
+            std::size_t used = 0;
+            st = feed_binary(std::string_view(in).substr(pos), used);
+            pos += used;
+            break;
+        }
+        const char* from = in.data() + pos + m_scanned;
+        const void* nl = std::memchr(from, '\n', in.size() - pos - m_scanned);
+        if (!nl) {
+            m_scanned = in.size() - pos;
+            if (m_scanned > kMaxLine) st = fail("line too long");
+            break;
+        }
+        const std::size_t end = static_cast<std::size_t>(static_cast<const char*>(nl) - in.data());
+        m_scanned = 0;
+        st = end - pos > kMaxLine ? fail("line too long") : feed(std::string_view(in.data() + pos, end - pos));
+        pos = end + 1;
+    }
+    in.erase(0, pos);
+    return st;
+}
+
+RequestParser::Status RequestParser::feed(std::string_view line) {
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+
+    switch (m_state) {
+    case State::Header: {
+        // Expected: ALG <ALGONAME> RAND|ERAND n m seed   or   ALG <ALGONAME> FILE
+        // (PIPE takes a comma-separated list of names in place of ALGONAME,
+        // LOAD has no name)
+        auto toks = split_view(line);
+        while (toks.size() > 1) {
+            if (toks.back() == "NOCACHE" && !m_req.no_cache) {
+                m_req.no_cache = true;
+                toks.pop_back();
+            } else if (toks.size() > 2 && toks[toks.size() - 2] == "TIMEOUT" && !m_req.timeout_ms) {
+                if (!parse_size(toks.back(), m_req.timeout_ms) || m_req.timeout_ms == 0) return fail("TIMEOUT usage");
+                toks.resize(toks.size() - 2);
+            } else {
+                break;
+            }
+        }
+        if (toks.size() == 1 && toks[0] == "STATS") {
+            m_req.stats = true;
+            m_state = State::Finished;
+            return Status::Done;
+        }
+        if (toks.size() < 2 || (toks[0] != "ALG" && toks[0] != "PIPE" && toks[0] != "LOAD") ||
+            (toks[0] != "LOAD" && toks.size() < 3))
+            return fail("bad request");
+        m_req.load = toks[0] == "LOAD";
+        const std::size_t in = m_req.load ? 1 : 2; // input mode token
+        if (toks[0] == "PIPE") {
+            std::string_view names = toks[1];
+            while (true) {
+                const std::size_t comma = std::min(names.find(','), names.size());
+                if (comma == 0) return fail("bad pipeline");
+                m_req.pipeline.emplace_back(names.substr(0, comma));
+                if (comma == names.size()) break;
+                names.remove_prefix(comma + 1);
+            }
+        } else if (!m_req.load) {
+            m_req.alg = std::string(toks[1]);
+        }
+        if (toks[in] == "RAND" || toks[in] == "ERAND") {
+            std::size_t seed = 0;
+            if ((toks.size() != in + 4 && toks.size() != in + 7) || !parse_size(toks[in + 1], m_req.n) ||
+                !parse_size(toks[in + 2], m_req.m) || !parse_size(toks[in + 3], seed))
+                return fail(std::string(toks[in]) + " usage");
+            if (toks.size() == in + 7) {
+                // Edge weights drawn uniformly from [lo, hi]
+                std::size_t lo = 0, hi = 0;
+                if (toks[in + 4] != "WEIGHT" || !parse_size(toks[in + 5], lo) || !parse_size(toks[in + 6], hi) ||
+                    lo > hi || hi > static_cast<std::size_t>(INT64_MAX))
+                    return fail(std::string(toks[in]) + " usage");
+                m_req.weighted = true;
+                m_req.weight_lo = static_cast<weight_t>(lo);
+                m_req.weight_hi = static_cast<weight_t>(hi);
+            }
+            m_req.source = toks[in] == "RAND" ? Request::Source::Rand : Request::Source::ERand;
+            m_req.seed = static_cast<unsigned>(seed);
+            m_state = State::Finished;
+            return Status::Done;
+        }
+        if (toks[in] == "FILE") {
+            m_req.source = Request::Source::File;
+            m_state = State::Counts;
+            return Status::NeedMore;
+        }
+        if (toks[in] == "BIN") {
+            if (!m_req.pipeline.empty()) return fail("PIPE takes RAND, ERAND, FILE or HANDLE input");
+            if (toks.size() != in + 1) return fail("BIN usage");
+            m_req.source = Request::Source::File;
+            m_req.binary = true;
+            m_state = State::BinHeader;
+            return Status::NeedMore;
+        }
+        if (toks[in] == "HANDLE" && !m_req.load) {
+            if (toks.size() != in + 2 || !parse_size(toks[in + 1], m_req.handle)) return fail("HANDLE usage");
+            m_req.source = Request::Source::Handle;
+            m_state = State::Finished;
+            return Status::Done;
+        }
+        return fail("unknown input mode");
+    }
+    case State::Counts:
+        if (!parse_pair(line, m_req.n, m_req.m)) return fail("bad n m");
+        try {
+            m_req.builder.emplace(m_req.n);
+        } catch (const std::exception& e) {
+            return fail(e.what());
+        }
+        m_req.builder->reserve(std::min<std::size_t>(m_req.m, std::size_t{1} << 20));
+        m_state = m_req.m ? State::Edges : State::End;
+        return Status::NeedMore;
+    case State::Edges: {
+        // Edge i is request line i+3: "u v", or "u v w" for a weighted edge
+        std::size_t f[3];
+        std::size_t count = 0;
+        for (auto tok = next_field(line); !tok.empty(); tok = next_field(line))
+            if (count == 3 || !parse_size(tok, f[count++])) return fail("bad edge");
+        if (count < 2 || (count == 3 && f[2] > static_cast<std::size_t>(INT64_MAX))) return fail("bad edge");
+        if (!(count == 3 ? m_req.builder->add_edge(f[0], f[1], static_cast<weight_t>(f[2]))
+                         : m_req.builder->add_edge(f[0], f[1]))) {
+            m_error = edge_error(*m_req.builder->error(), 3);
+            m_state = State::Finished;
+            return Status::Error;
+        }
+        if (++m_edges_read == m_req.m) m_state = State::End;
+        return Status::NeedMore;
+    }
+    case State::End:
+        if (line != "END") return fail("expected END");
+        m_state = State::Finished;
+        return Status::Done;
+    case State::BinHeader:
+    case State::BinEdges:
+    case State::Finished:
+        break;
+    }
+    return m_error.empty() ? Status::Done : Status::Error;
+}
+
+RequestParser::Status RequestParser::feed_binary(std::string_view in, std::size_t& used) {
+    used = 0;
+    if (m_state == State::BinHeader) {
+        if (in.size() < kFrameHeaderBytes + kGraphHeaderBytes) return Status::NeedMore;
+        if (!read_graph_header(in.data(), m_req.n, m_req.m)) return fail("bad frame");
+        try {
+            m_req.builder.emplace(m_req.n);
+        } catch (const std::exception& e) {
+            return fail(e.what());
+        }
+        m_req.builder->reserve(std::min<std::size_t>(m_req.m, std::size_t{1} << 20));
+        used = kFrameHeaderBytes + kGraphHeaderBytes;
+        m_state = State::BinEdges;
+    }
+    // Whole (u, v) pairs only; a split pair waits for the rest
+    const std::size_t k = std::min(m_req.m - m_edges_read, (in.size() - used) / 8);
+    if (!add_packed_edges(*m_req.builder, in.data() + used, k)) {
+        m_error = text_frame(binary_edge_error(*m_req.builder->error()));
+        m_state = State::Finished;
+        return Status::Error;
+    }
+    used += k * 8;
+    m_edges_read += k;
+    if (m_edges_read < m_req.m) return Status::NeedMore;
+    m_state = State::Finished;
+    return Status::Done;
+}
+
+std::string RequestParser::eof_error() const {
+    switch (m_state) {
+    case State::Counts: return "ERR missing n m\nEND\n";
+    case State::Edges: return "ERR missing edges\nEND\n";
+    case State::End: return "ERR expected END\nEND\n";
+    case State::BinHeader: return text_frame("ERR bad frame");
+    case State::BinEdges: return text_frame("ERR missing edges");
+    default: return {};
+    }
+}
+
+std::shared_ptr<const Graph> build_graph(Request& req, GraphStore& store, std::string& error) {
+    if (req.source == Request::Source::Handle) {
+        auto G = store.get(req.handle);
+        if (!G) error = "ERR unknown handle\nEND\n";
+        return G;
+    }
+    if (req.source == Request::Source::File) {
+        // Duplicate check + CSR construction in one pass
+        std::optional<Graph> built;
+        try {
+            built = req.builder->build();
+        } catch (const std::exception& e) {
+            error = std::string("ERR ") + e.what();
+            if (!req.binary) error += "\nEND\n";
+            return nullptr;
+        }
+        if (!built) {
+            const auto& e = *req.builder->error();
+            error = req.binary ? binary_edge_error(e) : edge_error(e, 3);
+            return nullptr;
+        }
+        req.builder.reset(); // the edges now live in the graph
+        return std::make_shared<const Graph>(std::move(*built));
+    }
+    try {
+        Graph G = req.source == Request::Source::ERand ? Graph::random_eulerian(req.n, req.m, req.seed)
+                                                       : Graph::random_simple(req.n, req.m, req.seed);
+        if (req.weighted) G = G.with_weights(Graph::random_weights(G.m(), req.weight_lo, req.weight_hi, req.seed));
+        return std::make_shared<const Graph>(std::move(G));
+    } catch (const std::exception& e) {
+        error = std::string("ERR ") + e.what() + "\nEND\n";
+        return nullptr;
+    }
+}
+
+std::string result_cache_key(const Request& req, const ResultCache& cache, const Graph* G) {
+    if (!cache.enabled() || req.no_cache || req.binary || req.load) return {};
+    if (req.source == Request::Source::Rand || req.source == Request::Source::ERand) {
+        std::string key = random_graph_key(req.source == Request::Source::ERand, req.n, req.m, req.seed);
+        if (req.weighted) key += " W " + std::to_string(req.weight_lo) + " " + std::to_string(req.weight_hi);
+        return key;
+    }
+    return G ? graph_digest_key(*G) : std::string();
+}
+
+void execute_request(Request& req, ServerContext& ctx, FdWriter& out, const CancelToken* cancel) {
+    Metrics& metrics = ctx.metrics;
+    if (req.stats) {
+        out.put("OK STATS\n");
+        out.put(metrics.text());
+        out.put("\nEND\n");
+        return;
+    }
+    // The reply is complete in 'out' once the result is: only the send is left
+    auto send = [&](Metrics::Clock::time_point from) {
+        out.flush();
+        metrics.record_since(kPhaseSend, from);
+    };
+
+    // A cached RAND/ERAND result needs no graph at all
+    std::string key = result_cache_key(req, ctx.cache, nullptr);
+    std::shared_ptr<const std::string> hit;
+    if (!key.empty() && (hit = ctx.cache.get(req.alg, key))) {
+        const auto t = Metrics::Clock::now();
+        out.put(*hit);
+        out.put("\nEND\n");
+        send(t);
+        return;
+    }
+
+    // Expired (or abandoned) while waiting for a thread, or while building
+    auto check_cancel = [&] {
+        if (!cancelled(cancel)) return false;
+        const std::string error = cancel_error(*cancel);
+        out.put(req.binary ? text_frame(error) : error + "\nEND\n");
+        return true;
+    };
+    if (check_cancel()) return;
+    std::string error;
+    auto t = Metrics::Clock::now();
+    auto G = build_graph(req, ctx.store, error);
+    metrics.record_since(kPhaseBuild, t);
+    if (check_cancel()) return;
+    if (!G) {
+        out.put(req.binary ? text_frame(error) : error);
+        return;
+    }
+    if (req.load) {
+        auto id = ctx.store.put(std::move(G));
+        std::string reply = id ? "OK HANDLE " + std::to_string(*id) : std::string("ERR graph exceeds memory budget");
+        out.put(req.binary ? text_frame(reply) : reply + "\nEND\n");
+        return;
+    }
+
+    AlgorithmArgs args;
+    const GraphAlgorithm* alg = find_algorithm(req.alg, args);
+    if (!alg) {
+        out.put(req.binary ? text_frame("ERR unknown algorithm") : "ERR unknown algorithm\nEND\n");
+        return;
+    }
+    const AlgorithmCall call{*G, args, cancel};
+    const std::size_t phase = algorithm_phase(*alg);
+    if (req.binary) {
+        t = Metrics::Clock::now();
+        alg->write_binary(call, out);
+        send(metrics.record_since(phase, t));
+        return;
+    }
+    const bool looked_up = !key.empty();
+    if (!looked_up) key = result_cache_key(req, ctx.cache, G.get());
+    if (!key.empty()) {
+        t = Metrics::Clock::now();
+        if (!looked_up && (hit = ctx.cache.get(req.alg, key))) {
+            out.put(*hit);
+        } else {
+            // Streamed like an uncached result; only a small one is also kept
+            ctx.cache.write_through(req.alg, key, out, [&](FdWriter& w) {
+                alg->write(call, w);
+                t = metrics.record_since(phase, t);
+                return w.ok() && !cancelled(cancel); // cut short: not kept
+            });
+        }
+        out.put("\nEND\n");
+        send(t);
+        return;
+    }
+
+    // Result (OK ... or ERR ...) goes straight to the client
+    t = Metrics::Clock::now();
+    alg->write(call, out);
+    t = metrics.record_since(phase, t);
+    out.put("\nEND\n");
+    send(t);
+}
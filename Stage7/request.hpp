@@ -0,0 +1,114 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "graph.hpp"
+#include "fd_writer.hpp"
+#include "cancel.hpp"
+#include "metrics.hpp"
+#include "graph_store.hpp"
+#include "request_watcher.hpp"
+#include "../Stage6/result_cache.hpp"
+
+// One parsed ALG, PIPE, LOAD or STATS request:
+//   ALG <NAME> RAND|ERAND n m seed [WEIGHT lo hi]
+//   ALG <NAME> FILE \n n m \n m lines "u v" or "u v w" \n END
+//   ALG <NAME> BIN \n GRPH frame (see Stage6/binary_protocol.hpp)
+//   ALG <NAME> HANDLE id            graph stored by an earlier LOAD
+//   PIPE <NAME>,<NAME>,... followed by RAND, ERAND, FILE or HANDLE input
+//   LOAD followed by RAND, ERAND, FILE or BIN input: store the graph and
+//        reply "OK HANDLE <id>"
+//   STATS   reply "OK STATS" and the server's metrics (Metrics::text())
+// A trailing NOCACHE on the first line bypasses the result cache, a trailing
+// TIMEOUT <ms> gives up on the request that long after it arrived (either
+// order, each at most once).
+// For FILE the edges are already recorded in 'builder'; build() and the
+// algorithm run later, on whichever thread executes the request.
+struct Request {
+    enum class Source { Rand, ERand, File, Handle };
+
+    std::string alg;                   // ALG only
+    std::vector<std::string> pipeline; // PIPE only: algorithms in reply order
+    Source source{Source::Rand};
+    std::size_t n{0}, m{0};
+    unsigned seed{0};
+    bool weighted{false};                // RAND/ERAND with WEIGHT lo hi
+    weight_t weight_lo{1}, weight_hi{1};
+    std::optional<GraphBuilder> builder; // FILE only
+    bool binary{false};                  // BIN: FILE input as a frame, reply is one frame
+    bool load{false};                    // LOAD
+    std::size_t handle{0};               // HANDLE only
+    bool no_cache{false};                // NOCACHE
+    std::size_t timeout_ms{0};           // TIMEOUT <ms>; 0: none
+    bool stats{false};                   // STATS
+    // When the last byte arrived; set by the server, not the parser
+    Metrics::Clock::time_point complete_at{};
+};
+
+// Incremental request parser. consume() is called with the connection's
+// input buffer whenever bytes arrive, so an upload never ties up a thread.
+class RequestParser {
+public:
+    enum class Status { NeedMore, Done, Error };
+
+    // Lines longer than this are rejected.
+    static constexpr std::size_t kMaxLine = 4096;
+
+    // Parse the complete lines in 'in' and erase them; a trailing partial
+    // line is kept for the next call. After "BIN" the rest is the binary
+    // frame, decoded as far as it has arrived. Stops at Done or Error.
+    Status consume(std::string& in);
+
+    // Parse one line (without '\n'; a trailing '\r' is ignored).
+    Status feed(std::string_view line);
+
+    // The peer closed its side before the request was complete.
+    // Returns the error response to send (empty if nothing was received).
+    // Responses for BIN requests are TEXT frames.
+    std::string eof_error() const;
+
+    Request take() { return std::move(m_req); }          // after Done
+    const std::string& error() const { return m_error; } // after Error: "ERR ...\nEND\n" (or frame)
+
+private:
+    enum class State { Header, Counts, Edges, End, BinHeader, BinEdges, Finished };
+
+    Status fail(std::string msg);
+    // Decode the binary frame at the front of 'in'; sets 'used' to the bytes taken.
+    Status feed_binary(std::string_view in, std::size_t& used);
+
+    State m_state{State::Header};
+    Request m_req;
+    std::size_t m_edges_read{0};
+    std::size_t m_scanned{0}; // bytes of the pending input known to hold no '\n'
+    std::string m_error;
+};
+
+// Server-wide state shared by every request.
+struct ServerContext {
+    GraphStore& store;
+    ResultCache& cache;       // text replies of ALG and PIPE
+    RequestWatcher& watcher;  // deadlines and hang-ups of complete requests
+    std::size_t timeout_ms;   // default and upper bound for TIMEOUT; 0: none
+    Metrics& metrics;         // see server_metrics.hpp
+};
+
+// Key of the request's graph for the result cache; empty if the request
+// must not use it. RAND/ERAND keys come from the parameters, so G may be
+// nullptr for them; other inputs hash the built graph.
+std::string result_cache_key(const Request& req, const ResultCache& cache, const Graph* G);
+
+// Build (FILE), generate or look up (HANDLE) the request's graph. On failure
+// returns nullptr and sets 'error' to the response ("ERR ...\nEND\n"; for
+// BIN requests the "ERR ..." text still to be framed).
+std::shared_ptr<const Graph> build_graph(Request& req, GraphStore& store, std::string& error);
+
+// Build the graph, run the algorithm (or store the graph for LOAD) and write
+// "<result>\nEND\n" to 'out' (one result frame for BIN requests). Once
+// 'cancel' fires the result is cancel_error() instead and is not cached.
+void execute_request(Request& req, ServerContext& ctx, FdWriter& out, const CancelToken* cancel = nullptr);
@@ -0,0 +1,136 @@
+#include "request_watcher.hpp"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <utility>
+
+RequestWatcher::Watch& RequestWatcher::Watch::operator=(Watch&& other) noexcept {
+    if (this != &other) {
+        reset();
+        m_watcher = std::exchange(other.m_watcher, nullptr);
+        m_id = other.m_id;
+        m_token = std::move(other.m_token);
+    }
+    return *this;
+}
+
+void RequestWatcher::Watch::reset() {
+    if (m_watcher) m_watcher->unwatch(m_id);
+    m_watcher = nullptr;
+}
+
+RequestWatcher::RequestWatcher() {
+    m_ep = ::epoll_create1(EPOLL_CLOEXEC);
+    m_wake = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = 0; // 0 marks the wake-up descriptor; entries start at 1
+    if (m_ep < 0 || m_wake < 0 || ::epoll_ctl(m_ep, EPOLL_CTL_ADD, m_wake, &ev) < 0) {
+        perror("request watcher");
+        if (m_ep >= 0) ::close(m_ep);
+        if (m_wake >= 0) ::close(m_wake);
+        m_ep = m_wake = -1;
+        return;
+    }
+    m_thread = std::thread([this] { loop(); });
+}
+
+RequestWatcher::~RequestWatcher() {
+    if (m_ep < 0) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mu);
+        m_stop = true;
+    }
+    const std::uint64_t one = 1;
+    (void)!::write(m_wake, &one, sizeof(one));
+    m_thread.join();
+    ::close(m_ep);
+    ::close(m_wake);
+}
+
+RequestWatcher::Watch RequestWatcher::watch(int fd, std::optional<std::chrono::milliseconds> timeout) {
+    Watch w;
+    w.m_token = std::make_shared<CancelToken>();
+    if (m_ep < 0) return w;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mu);
+        w.m_watcher = this;
+        w.m_id = m_next_id++;
+        Entry& e = m_entries[w.m_id];
+        e = Entry{fd, w.m_token, std::nullopt, true};
+        if (timeout) e.deadline = Clock::now() + *timeout;
+        // No event bits: EPOLLHUP and EPOLLERR are always reported
+        epoll_event ev{};
+        ev.events = 0;
+        ev.data.u64 = w.m_id;
+        if (::epoll_ctl(m_ep, EPOLL_CTL_ADD, fd, &ev) < 0) e.watching = false;
+    }
+    if (timeout) {
+        // The loop may be asleep past the new deadline
+        const std::uint64_t one = 1;
+        (void)!::write(m_wake, &one, sizeof(one));
+    }
+    return w;
+}
+
+void RequestWatcher::unwatch(std::uint64_t id) {
+    std::lock_guard<std::mutex> lock(m_mu);
+    auto it = m_entries.find(id);
+    if (it == m_entries.end()) return;
+    if (it->second.watching) ::epoll_ctl(m_ep, EPOLL_CTL_DEL, it->second.fd, nullptr);
+    m_entries.erase(it);
+}
+
+void RequestWatcher::on_event(std::uint64_t id) {
+    std::lock_guard<std::mutex> lock(m_mu);
+    auto it = m_entries.find(id);
+    if (it == m_entries.end() || !it->second.watching) return; // already unwatched
+    Entry& e = it->second;
+    e.token->cancel(CancelToken::Reason::Disconnected);
+    ::epoll_ctl(m_ep, EPOLL_CTL_DEL, e.fd, nullptr);
+    e.watching = false;
+}
+
+int RequestWatcher::expire() {
+    std::lock_guard<std::mutex> lock(m_mu);
+    const Clock::time_point now = Clock::now();
+    std::optional<Clock::time_point> next;
+    for (auto& [id, e] : m_entries) {
+        if (!e.deadline) continue;
+        if (*e.deadline <= now) {
+            e.token->cancel(CancelToken::Reason::Timeout);
+            e.deadline.reset();
+        } else if (!next || *e.deadline < *next) {
+            next = e.deadline;
+        }
+    }
+    if (!next) return -1;
+    // Round up so the wake-up is never early
+    return static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(*next - now).count());
+}
+
+void RequestWatcher::loop() {
+    epoll_event events[64];
+    while (true) {
+        const int k = ::epoll_wait(m_ep, events, 64, expire());
+        if (k < 0 && errno != EINTR) {
+            perror("request watcher: epoll_wait");
+            return;
+        }
+        for (int i = 0; i < k; ++i) {
+            if (events[i].data.u64 != 0) {
+                on_event(events[i].data.u64);
+                continue;
+            }
+            std::uint64_t n;
+            (void)!::read(m_wake, &n, sizeof(n));
+            std::lock_guard<std::mutex> lock(m_mu);
+            if (m_stop) return;
+        }
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+
+#include "cancel.hpp"
+
+// Cancels requests that outlive their deadline or lose their client while
+// they wait in a queue or run. One thread with its own epoll set watches
+// the sockets of complete requests for hang-ups and sleeps until the
+// nearest deadline in between.
+//
+// Only a hang-up or error on the socket (EPOLLHUP/EPOLLERR, e.g. a reset)
+// cancels. A FIN from the client is never enough, whenever it arrives:
+// shutdown(SHUT_WR) after sending and then waiting for the reply is a normal
+// client. A client that close()s and goes away looks the same until the
+// reply to it fails, which the server counts as a disconnect.
+class RequestWatcher {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // A watched request: owns its token and stops watching when reset or
+    // destroyed. Must be reset before the socket is closed, or a new
+    // connection reusing the descriptor could be cancelled in its place.
+    class Watch {
+    public:
+        Watch() = default;
+        Watch(Watch&& other) noexcept { *this = std::move(other); }
+        Watch& operator=(Watch&& other) noexcept;
+        ~Watch() { reset(); }
+
+        void reset();
+        const CancelToken* token() const { return m_token.get(); } // nullptr when empty
+
+    private:
+        friend class RequestWatcher;
+
+        RequestWatcher* m_watcher = nullptr;
+        std::uint64_t m_id = 0;
+        std::shared_ptr<CancelToken> m_token;
+    };
+
+    RequestWatcher();
+    ~RequestWatcher();
+
+    RequestWatcher(const RequestWatcher&) = delete;
+    RequestWatcher& operator=(const RequestWatcher&) = delete;
+
+    // Start watching the connected socket 'fd' of a request completed just
+    // now; with a timeout its token fires Timeout that long from now, and a
+    // hang-up fires Disconnected. If the watcher could not start, the
+    // token still works but nothing cancels it.
+    Watch watch(int fd, std::optional<std::chrono::milliseconds> timeout);
+
+private:
+    struct Entry {
+        int fd;
+        std::shared_ptr<CancelToken> token;
+        std::optional<Clock::time_point> deadline;
+        bool watching; // still registered with m_ep
+    };
+
+    void loop();
+    void unwatch(std::uint64_t id);
+    void on_event(std::uint64_t id); // HUP or ERR on the socket
+    // Fire expired deadlines; returns the epoll_wait timeout until the next one.
+    int expire();
+
+    int m_ep = -1;
+    int m_wake = -1; // eventfd: new deadline or shutdown
+    std::mutex m_mu;
+    std::unordered_map<std::uint64_t, Entry> m_entries;
+    std::uint64_t m_next_id = 1;
+    bool m_stop = false;
+    std::thread m_thread;
+};
@@ -0,0 +1,38 @@
+#include "server_metrics.hpp"
+
+#include <string>
+#include <vector>
+
+#include "algorithms.hpp"
+
+std::unique_ptr<Metrics> make_server_metrics(const ResultCache& cache, const GraphStore& store) {
+    std::vector<std::string> phases = {"accept", "receive", "queue", "build", "send", "total"};
+    for (std::string_view name : algorithm_names()) phases.emplace_back(name);
+    std::vector<std::string> counters = {"connections", "requests", "pipe_requests", "load_requests",
+                                         "stats_requests", "bad_requests", "busy", "timeouts", "disconnects"};
+    auto num = [](auto v) { return static_cast<double>(v); };
+    std::vector<Metrics::Gauge> gauges = {
+        {"cache_hits", [&cache, num] { return num(cache.stats().hits); }},
+        {"cache_misses", [&cache, num] { return num(cache.stats().misses); }},
+        {"cache_entries", [&cache, num] { return num(cache.stats().entries); }},
+        {"cache_bytes", [&cache, num] { return num(cache.stats().bytes); }},
+        {"store_graphs", [&store, num] { return num(store.usage().graphs); }},
+        {"store_bytes", [&store, num] { return num(store.usage().bytes); }},
+    };
+    return std::make_unique<Metrics>(std::move(phases), std::move(counters), std::move(gauges));
+}
+
+std::size_t algorithm_phase(const GraphAlgorithm& alg) {
+    static const std::vector<std::string_view> names = algorithm_names();
+    std::size_t i = 0;
+    while (i < names.size() && names[i] != alg.name()) ++i;
+    return kPhaseAlgorithms + i;
+}
+
+void count_cancelled(Metrics& metrics, const CancelToken* token, bool sent) {
+    if (!cancelled(token)) {
+        if (!sent) metrics.add(kCountDisconnects);
+        return;
+    }
+    metrics.add(token->reason() == CancelToken::Reason::Timeout ? kCountTimeouts : kCountDisconnects);
+}
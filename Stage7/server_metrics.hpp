@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+
+#include "metrics.hpp"
+#include "cancel.hpp"
+#include "graph_store.hpp"
+#include "../Stage6/result_cache.hpp"
+
+class GraphAlgorithm;
+
+// Latency phases alg_server records, in the order a request meets them.
+enum ServerPhase : std::size_t {
+    kPhaseAccept,     // accept4 and epoll registration of one connection
+    kPhaseReceive,    // accepted -> request complete (upload and parsing)
+    kPhaseQueue,      // complete -> taken by a thread (worker, or PIPE's BUILD)
+    kPhaseBuild,      // build, generate or look up the graph
+    kPhaseSend,       // result ready -> reply flushed to the socket
+    kPhaseTotal,      // complete -> connection closed
+    kPhaseAlgorithms, // then one per registered algorithm: its run, including
+                      // output it streams as it goes (see algorithm_phase())
+};
+
+// Events alg_server counts.
+enum ServerCounter : std::size_t {
+    kCountConnections,
+    kCountRequests,     // complete requests of every kind
+    kCountPipe,         // ... of which PIPE
+    kCountLoad,         // ... LOAD
+    kCountStats,        // ... STATS
+    kCountBadRequests,  // rejected by the parser
+    kCountBusy,         // answered "ERR server busy"
+    kCountTimeouts,     // token fired on the deadline
+    kCountDisconnects,  // token fired on a hang-up
+};
+
+// The server's Metrics; result cache and graph store sizes are gauges read
+// from 'cache' and 'store', which must outlive it.
+std::unique_ptr<Metrics> make_server_metrics(const ResultCache& cache, const GraphStore& store);
+
+// Phase of 'alg' (kPhaseAlgorithms + its position in the registry).
+std::size_t algorithm_phase(const GraphAlgorithm& alg);
+
+// Count a request whose token fired (kCountTimeouts or kCountDisconnects),
+// or whose reply could not be sent (kCountDisconnects); nothing otherwise.
+void count_cancelled(Metrics& metrics, const CancelToken* token, bool sent = true);
@@ -0,0 +1,95 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// FIFO with a fixed capacity, safe for any number of producers/consumers.
+// close() wakes all waiters; pop() then drains what is left and returns
+// std::nullopt once the queue is empty.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(std::size_t capacity) : m_capacity(capacity ? capacity : 1) {}
+
+    // Blocks while full. Returns false if the queue was closed.
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(m_mu);
+        m_not_full.wait(lock, [&] { return m_closed || m_items.size() < m_capacity; });
+        if (m_closed) return false;
+        m_items.push_back(std::move(item));
+        m_not_empty.notify_one();
+        return true;
+    }
+
+    // Never blocks. Returns false if full or closed ('item' is left intact).
+    bool try_push(T& item) {
+        std::lock_guard<std::mutex> lock(m_mu);
+        if (m_closed || m_items.size() >= m_capacity) return false;
+        m_items.push_back(std::move(item));
+        m_not_empty.notify_one();
+        return true;
+    }
+
+    std::optional<T> pop() {
+        std::unique_lock<std::mutex> lock(m_mu);
+        m_not_empty.wait(lock, [&] { return m_closed || !m_items.empty(); });
+        if (m_items.empty()) return std::nullopt;
+        T item = std::move(m_items.front());
+        m_items.pop_front();
+        m_not_full.notify_one();
+        return item;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(m_mu);
+        m_closed = true;
+        m_not_empty.notify_all();
+        m_not_full.notify_all();
+    }
+
+private:
+    std::mutex m_mu;
+    std::condition_variable m_not_empty, m_not_full;
+    std::deque<T> m_items;
+    std::size_t m_capacity;
+    bool m_closed{false};
+};
+
+// Fixed set of threads running 'handler' on tasks from a BoundedQueue.
+// The destructor closes the queue, finishes queued tasks and joins.
+template <typename Task>
+class WorkerPool {
+public:
+    WorkerPool(unsigned threads, std::size_t capacity, std::function<void(Task&)> handler)
+        : m_queue(capacity), m_handler(std::move(handler)) {
+        if (threads == 0) threads = 1;
+        for (unsigned i = 0; i < threads; ++i)
+            m_threads.emplace_back([this] {
+                while (auto task = m_queue.pop()) m_handler(*task);
+            });
+    }
+    ~WorkerPool() {
+        m_queue.close();
+        for (auto& t : m_threads) t.join();
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Blocks while the queue is full. Returns false once shut down.
+    bool submit(Task task) { return m_queue.push(std::move(task)); }
+
+    // Returns false (and leaves 'task' intact) if the queue is full.
+    bool try_submit(Task& task) { return m_queue.try_push(task); }
+
+private:
+    BoundedQueue<Task> m_queue;
+    std::function<void(Task&)> m_handler;
+    std::vector<std::thread> m_threads;
+};
@@ -0,0 +1,110 @@
+// Components of random graphs: the previous SCC implementation (recursive
+// Kosaraju that rebuilds the transpose with Graph::add_edge and formats with
+// an ostringstream) versus iterative Tarjan and the parallel union-find
+// mode (Stage7/components.cpp), each writing the same text into a string.
+// The old version only runs up to -L vertices: its recursion depth grows
+// with the graph and overflows the stack on long paths.
+//
+//   ./bench_components -n 20000,1000000,4000000 -d 3 -L 50000 -r 3
+
+#include "graph.hpp"
+#include "components.hpp"
+#include "parallel.hpp"
+#include "bench_util.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// The pre-Tarjan SccAlg, unchanged apart from the class wrapper.
+static void dfs1(const Graph& G, size_t u, std::vector<int>& vis, std::vector<size_t>& order) {
+    vis[u] = 1;
+    for (size_t v : G.neighbors(u)) if (!vis[v]) dfs1(G, v, vis, order);
+    order.push_back(u);
+}
+
+static void dfs2(const Graph& GT, size_t u, std::vector<int>& vis, std::vector<size_t>& comp) {
+    vis[u] = 1; comp.push_back(u);
+    for (size_t v : GT.neighbors(u)) if (!vis[v]) dfs2(GT, v, vis, comp);
+}
+
+static std::string old_scc(const Graph& G) {
+    size_t n = G.num_vertices();
+    std::vector<int> vis(n, 0);
+    std::vector<size_t> order;
+
+    for (size_t i = 0; i < n; i++) if (!vis[i]) dfs1(G, i, vis, order);
+
+    Graph GT(n);
+    for (size_t u = 0; u < n; u++) for (size_t v : G.neighbors(u)) GT.add_edge(v, u);
+    GT.finalize();
+
+    std::fill(vis.begin(), vis.end(), 0);
+    std::ostringstream os;
+    os << "OK SCC\n";
+
+    for (int i = (int)order.size() - 1; i >= 0; i--) {
+        size_t u = order[i];
+        if (!vis[u]) {
+            std::vector<size_t> comp;
+            dfs2(GT, u, vis, comp);
+            for (size_t j = 0; j < comp.size(); j++) {
+                if (j) os << " ";
+                os << comp[j];
+            }
+            os << "\n";
+        }
+    }
+    return os.str();
+}
+
+// Same text as SccAlg::run: "OK SCC\n" plus one line per component.
+struct TextSink {
+    std::string out = "OK SCC\n";
+    std::size_t components = 0;
+    ComponentSink sink() {
+        return [this](const vertex_t* vs, std::size_t count) {
+            char buf[24];
+            for (std::size_t i = 0; i < count; ++i) {
+                if (i) out += ' ';
+                out.append(buf, std::to_chars(buf, buf + sizeof(buf), vs[i]).ptr);
+            }
+            out += '\n';
+            ++components;
+            return true;
+        };
+    }
+};
+
+int main(int argc, char** argv) {
+    std::vector<std::size_t> sizes;
+    std::istringstream list(arg_str(argc, argv, "-n", "20000,1000000,4000000"));
+    for (std::string t; std::getline(list, t, ',');) sizes.push_back(std::stoull(t));
+    const std::size_t degree = arg_u64(argc, argv, "-d", 3); // m = degree * n / 2
+    const std::size_t limit = arg_u64(argc, argv, "-L", 50000);
+    const unsigned seed = static_cast<unsigned>(arg_u64(argc, argv, "-s", 1));
+    const int reps = static_cast<int>(arg_u64(argc, argv, "-r", 3));
+    const unsigned threads = static_cast<unsigned>(arg_u64(argc, argv, "-t", default_threads()));
+
+    std::printf("%10s %10s %12s %12s %12s %12s\n", "n", "m", "old ms", "tarjan ms", "uf ms", "components");
+    for (std::size_t n : sizes) {
+        const Graph G = Graph::random_simple(n, degree * n / 2, seed);
+        TextSink tarjan, uf;
+        const double t_tarjan = best_of(reps, [&] { tarjan = TextSink(); for_each_scc(G, tarjan.sink()); });
+        const double t_uf = best_of(reps, [&] { uf = TextSink(); for_each_component(G, uf.sink(), threads); });
+        const bool same = tarjan.components == uf.components && tarjan.out.size() == uf.out.size();
+
+        std::string old_ms = "-";
+        if (n <= limit) {
+            std::string text;
+            const double t = best_of(reps, [&] { text = old_scc(G); });
+            old_ms = text.size() == uf.out.size() ? std::to_string(static_cast<long>(t)) : "MISMATCH";
+        }
+        std::printf("%10zu %10zu %12s %12.1f %12.1f %12zu%s\n", n, G.m(), old_ms.c_str(), t_tarjan, t_uf,
+                    uf.components, same ? "" : "  MISMATCH");
+    }
+    return 0;
+}
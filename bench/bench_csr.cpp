@@ -0,0 +1,47 @@
+// Memory and traversal time of the frozen CSR graph versus the
+// vector-of-vectors build representation.
+//
+//   ./bench_csr -n 2000000 -m 8000000 -s 1 -r 5
+
+#include "graph.hpp"
+#include "bench_util.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Touch every adjacency entry once (what most algorithms do per pass).
+static std::uint64_t sweep(const Graph& g) {
+    std::uint64_t acc = 0;
+    for (std::size_t u = 0; u < g.n(); ++u)
+        for (vertex_t v : g.neighbors(u)) acc += v;
+    return acc;
+}
+
+int main(int argc, char** argv) {
+    const std::size_t n = arg_u64(argc, argv, "-n", 1000000);
+    const std::size_t m = arg_u64(argc, argv, "-m", 4000000);
+    const unsigned seed = static_cast<unsigned>(arg_u64(argc, argv, "-s", 1));
+    const int reps = static_cast<int>(arg_u64(argc, argv, "-r", 5));
+
+    Graph csr = Graph::random_simple(n, m, seed);
+
+    // Rebuild the same graph (same neighbor order) in list mode
+    Graph lists(n);
+    for (std::size_t u = 0; u < n; ++u)
+        for (vertex_t v : csr.neighbors(u))
+            if (u < v) lists.add_edge(u, v);
+
+    std::uint64_t a = 0, b = 0;
+    double t_lists = best_of(reps, [&] { a = sweep(lists); });
+    double t_csr = best_of(reps, [&] { b = sweep(csr); });
+    double c_lists = best_of(reps, [&] { (void)lists.is_connected_ignoring_isolated(); });
+    double c_csr = best_of(reps, [&] { (void)csr.is_connected_ignoring_isolated(); });
+    if (a != b) { std::fprintf(stderr, "checksum mismatch\n"); return 1; }
+
+    std::printf("graph: n=%zu m=%zu\n", n, m);
+    std::printf("%-8s %12s %12s %12s\n", "layout", "MiB", "sweep ms", "bfs ms");
+    std::printf("%-8s %12.1f %12.2f %12.2f\n", "lists", mib(lists.memory_bytes()), t_lists, c_lists);
+    std::printf("%-8s %12.1f %12.2f %12.2f\n", "csr", mib(csr.memory_bytes()), t_csr, c_csr);
+    return 0;
+}
@@ -0,0 +1,236 @@
+// Algorithm dispatch and result formatting: the previous factory (a chain of
+// std::string compares returning a new'd GraphAlgorithm whose run() builds
+// the reply with std::to_string / to_chars) versus the compile-time
+// registry in Stage7/algorithms.cpp (perfect-hash lookup of a stateless
+// singleton that writes into a caller's buffer through FdWriter).
+//
+//  1. lookup only: create + delete versus find_algorithm, per name
+//  2. small requests: lookup + run + format on a graph of -n vertices, the
+//     per-request overhead the server pays on top of the algorithm
+//  3. large results: SCC:CC and MST:EDGES text on -N vertices (formatting
+//     dominates); each reply must match the old one byte for byte
+//
+//   ./bench_dispatch -n 12 -N 1000000 -k 200000 -r 5
+
+#include "graph.hpp"
+#include "algorithms.hpp"
+#include "components.hpp"
+#include "mst.hpp"
+#include "max_flow.hpp"
+#include "hamilton.hpp"
+#include "parallel.hpp"
+#include "line_reader.hpp"
+#include "bench_util.hpp"
+
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace old {
+
+// The pre-registry interface and factory, minus EULER (whose run() only
+// wraps the circuit writer) and the cancellation plumbing.
+struct GraphAlgorithm {
+    virtual std::string name() const = 0;
+    virtual std::string run(const Graph& G) = 0;
+    virtual ~GraphAlgorithm() = default;
+};
+
+class MstWeightAlg : public GraphAlgorithm {
+public:
+    enum class Mode { Auto, Kruskal, Boruvka };
+    MstWeightAlg(Mode mode = Mode::Auto, bool edges = false) : m_mode(mode), m_edges(edges) {}
+    std::string name() const override { return "MST"; }
+    std::string run(const Graph& G) override {
+        const unsigned threads = default_threads();
+        const bool parallel = m_mode == Mode::Boruvka ||
+                              (m_mode == Mode::Auto && threads >= 4 && G.m() >= (std::size_t{1} << 20));
+        MstResult r = parallel ? mst_boruvka(G, threads, m_edges) : mst_kruskal(G, m_edges);
+        std::string out = "OK MST_WEIGHT " + std::to_string(r.total);
+        if (!m_edges) return out;
+        out += " EDGES " + std::to_string(r.edges);
+        out.reserve(out.size() + r.forest.size() * 16);
+        char buf[24];
+        for (const MstEdge& e : r.forest) {
+            out += '\n';
+            out.append(buf, std::to_chars(buf, buf + sizeof(buf), e.u).ptr);
+            out += ' ';
+            out.append(buf, std::to_chars(buf, buf + sizeof(buf), e.v).ptr);
+            out += ' ';
+            out.append(buf, std::to_chars(buf, buf + sizeof(buf), e.w).ptr);
+        }
+        return out;
+    }
+private:
+    Mode m_mode;
+    bool m_edges;
+};
+
+class SccAlg : public GraphAlgorithm {
+public:
+    explicit SccAlg(bool union_find = false) : m_union_find(union_find) {}
+    std::string name() const override { return "SCC"; }
+    std::string run(const Graph& G) override {
+        std::string out = "OK SCC\n";
+        char buf[24];
+        const ComponentSink sink = [&](const vertex_t* vs, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                if (i) out += ' ';
+                out.append(buf, std::to_chars(buf, buf + sizeof(buf), vs[i]).ptr);
+            }
+            out += '\n';
+            return true;
+        };
+        if (m_union_find) for_each_component(G, sink, default_threads());
+        else for_each_scc(G, sink);
+        return out;
+    }
+private:
+    bool m_union_find;
+};
+
+class MaxFlowAlg : public GraphAlgorithm {
+public:
+    MaxFlowAlg() = default;
+    MaxFlowAlg(size_t s, size_t t) : m_ends(true), m_s(s), m_t(t) {}
+    std::string name() const override { return "MAXFLOW"; }
+    std::string run(const Graph& G) override {
+        size_t n = G.num_vertices();
+        size_t s = m_ends ? m_s : 0, t = m_ends ? m_t : n - 1;
+        if (n < 2) return "ERR MAXFLOW needs at least 2 vertices";
+        if (s >= n || t >= n) return "ERR MAXFLOW source/sink out of range";
+        if (s == t) return "ERR MAXFLOW source equals sink";
+        return "OK MAXFLOW " + std::to_string(max_flow(G, s, t));
+    }
+private:
+    bool m_ends{false};
+    size_t m_s{0}, m_t{0};
+};
+
+class HamiltonAlg : public GraphAlgorithm {
+public:
+    std::string name() const override { return "HAMILTON"; }
+    std::string run(const Graph& G) override {
+        const std::vector<vertex_t> cycle = hamilton_cycle(G, default_threads());
+        if (cycle.empty()) return "ERR No Hamiltonian cycle";
+        std::string out = "OK HAMILTON";
+        char buf[24];
+        for (vertex_t v : cycle) {
+            out += ' ';
+            out.append(buf, std::to_chars(buf, buf + sizeof(buf), v).ptr);
+        }
+        return out;
+    }
+};
+
+GraphAlgorithm* create_algorithm(const std::string& alg_name) {
+    if (alg_name == "EULER") return nullptr; // not part of this comparison
+    if (alg_name == "MST" || alg_name.rfind("MST:", 0) == 0) {
+        auto mode = MstWeightAlg::Mode::Auto;
+        bool edges = false;
+        std::string_view opts = std::string_view(alg_name).substr(3);
+        while (!opts.empty()) {
+            opts.remove_prefix(1);
+            const std::string_view opt = opts.substr(0, opts.find(':'));
+            opts.remove_prefix(opt.size());
+            if (opt == "EDGES" && !edges) edges = true;
+            else if (opt == "KRUSKAL" && mode == MstWeightAlg::Mode::Auto) mode = MstWeightAlg::Mode::Kruskal;
+            else if (opt == "BORUVKA" && mode == MstWeightAlg::Mode::Auto) mode = MstWeightAlg::Mode::Boruvka;
+            else return nullptr;
+        }
+        return new MstWeightAlg(mode, edges);
+    }
+    if (alg_name == "SCC") return new SccAlg();
+    if (alg_name == "SCC:CC") return new SccAlg(true);
+    if (alg_name == "MAXFLOW") return new MaxFlowAlg();
+    if (alg_name.rfind("MAXFLOW:", 0) == 0) {
+        std::string_view args = std::string_view(alg_name).substr(8);
+        const size_t colon = args.find(':');
+        size_t s = 0, t = 0;
+        if (colon == std::string_view::npos || !parse_size(args.substr(0, colon), s) ||
+            !parse_size(args.substr(colon + 1), t))
+            return nullptr;
+        return new MaxFlowAlg(s, t);
+    }
+    if (alg_name == "HAMILTON") return new HamiltonAlg();
+    return nullptr;
+}
+
+} // namespace old
+
+static volatile std::uintptr_t g_sink; // keeps the lookup loops from being optimized away
+
+// The new path as request.cpp runs it for a cached result.
+static void new_request(const std::string& name, const Graph& G, std::string& out) {
+    AlgorithmArgs args;
+    const GraphAlgorithm* alg = find_algorithm(name, args);
+    out.clear();
+    if (alg) alg->append({G, args, nullptr}, out);
+}
+
+static std::string old_request(const std::string& name, const Graph& G) {
+    std::unique_ptr<old::GraphAlgorithm> alg(old::create_algorithm(name));
+    return alg ? alg->run(G) : std::string();
+}
+
+int main(int argc, char** argv) {
+    const std::size_t small_n = arg_u64(argc, argv, "-n", 12);
+    const std::size_t large_n = arg_u64(argc, argv, "-N", 1000000);
+    const std::size_t iters = arg_u64(argc, argv, "-k", 200000);
+    const int reps = static_cast<int>(arg_u64(argc, argv, "-r", 5));
+    const std::vector<std::string> names = {"MST", "MST:EDGES", "SCC", "SCC:CC", "MAXFLOW", "MAXFLOW:2:7",
+                                            "HAMILTON", "NOSUCH"};
+
+    std::printf("%-24s %14s %14s\n", "lookup (ns/name)", "old", "registry");
+    for (const auto& name : names) {
+        std::uintptr_t sink = 0;
+        const double t_old = best_of(reps, [&] {
+            for (std::size_t i = 0; i < iters; ++i) {
+                std::unique_ptr<old::GraphAlgorithm> alg(old::create_algorithm(name));
+                sink += reinterpret_cast<std::uintptr_t>(alg.get()) & 1;
+            }
+        });
+        const double t_new = best_of(reps, [&] {
+            for (std::size_t i = 0; i < iters; ++i) {
+                AlgorithmArgs args;
+                sink += reinterpret_cast<std::uintptr_t>(find_algorithm(name, args)) + args.a;
+            }
+        });
+        g_sink = sink;
+        std::printf("%-24s %14.1f %14.1f\n", name.c_str(), t_old * 1e6 / iters, t_new * 1e6 / iters);
+    }
+
+    std::printf("\n%-24s %14s %14s\n", "small request (ns)", "old", "registry");
+    const Graph small = Graph::random_simple(small_n, 2 * small_n, 1).with_weights(
+        Graph::random_weights(2 * small_n, 1, 9, 1));
+    const std::size_t small_iters = iters / 10 ? iters / 10 : 1;
+    for (const auto& name : names) {
+        std::string reply, expect = old_request(name, small);
+        new_request(name, small, reply);
+        const bool same = reply == expect;
+        const double t_old = best_of(reps, [&] {
+            for (std::size_t i = 0; i < small_iters; ++i) reply = old_request(name, small);
+        });
+        const double t_new = best_of(reps, [&] {
+            for (std::size_t i = 0; i < small_iters; ++i) new_request(name, small, reply);
+        });
+        std::printf("%-24s %14.0f %14.0f%s\n", name.c_str(), t_old * 1e6 / small_iters, t_new * 1e6 / small_iters,
+                    same ? "" : "  MISMATCH");
+    }
+
+    std::printf("\n%-24s %14s %14s %10s\n", "large result (ms)", "old", "registry", "MiB");
+    const Graph sparse = Graph::random_simple(large_n, large_n / 2, 2);
+    const Graph weighted = Graph::random_simple(large_n, 3 * large_n, 3).with_weights(
+        Graph::random_weights(3 * large_n, 1, 1000000, 3));
+    for (const auto& [name, G] : {std::make_pair("SCC:CC", &sparse), std::make_pair("MST:EDGES", &weighted)}) {
+        std::string expect, reply;
+        const double t_old = best_of(reps, [&] { expect = old_request(name, *G); });
+        const double t_new = best_of(reps, [&] { new_request(name, *G, reply); });
+        std::printf("%-24s %14.1f %14.1f %10.1f%s\n", name, t_old, t_new, mib(reply.size()),
+                    reply == expect ? "" : "  MISMATCH");
+    }
+    return 0;
+}
@@ -0,0 +1,68 @@
+// Euler circuit construction: copy-and-erase Hierholzer (previous
+// implementation) versus the edge-id/cursor version. Every produced circuit
+// is checked to use each edge exactly once.
+//
+//   ./bench_euler -n 1000000 -m 8000000 -s 1 -r 3
+
+#include "graph.hpp"
+#include "euler.hpp"
+#include "bench_util.hpp"
+#include "bench_graphs.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <stack>
+#include <vector>
+
+// Previous implementation: copies the adjacency and erases both directions
+// of every traversed edge with a linear scan.
+static std::vector<std::size_t> legacy_circuit(const Graph& G) {
+    const std::size_t n = G.n();
+    std::vector<std::vector<std::size_t>> adj(n);
+    for (std::size_t u = 0; u < n; ++u) adj[u].assign(G.neighbors(u).begin(), G.neighbors(u).end());
+    std::vector<std::size_t> out;
+    std::size_t start = 0;
+    for (std::size_t i = 0; i < n; ++i) if (!adj[i].empty()) { start = i; break; }
+    std::stack<std::size_t> st;
+    st.push(start);
+    auto remove_edge = [&](std::size_t u, std::size_t v) {
+        auto& Au = adj[u];
+        for (std::size_t i = 0; i < Au.size(); ++i) if (Au[i] == v) { Au[i] = Au.back(); Au.pop_back(); break; }
+        auto& Av = adj[v];
+        for (std::size_t i = 0; i < Av.size(); ++i) if (Av[i] == u) { Av[i] = Av.back(); Av.pop_back(); break; }
+    };
+    while (!st.empty()) {
+        std::size_t u = st.top();
+        if (!adj[u].empty()) {
+            std::size_t v = adj[u].back();
+            adj[u].pop_back();
+            remove_edge(u, v);
+            st.push(v);
+        } else {
+            out.push_back(u);
+            st.pop();
+        }
+    }
+    std::reverse(out.begin(), out.end());
+    return out;
+}
+
+int main(int argc, char** argv) {
+    const std::size_t n = arg_u64(argc, argv, "-n", 200000);
+    const std::size_t m = arg_u64(argc, argv, "-m", 2000000);
+    const unsigned seed = static_cast<unsigned>(arg_u64(argc, argv, "-s", 1));
+    const int reps = static_cast<int>(arg_u64(argc, argv, "-r", 3));
+
+    Graph g = Graph::random_eulerian(n, m, seed);
+    if (!euler_feasibility(g).ok) { std::fprintf(stderr, "fixture is not Eulerian\n"); return 1; }
+
+    std::vector<std::size_t> a, b;
+    double t_old = best_of(reps, [&] { a = legacy_circuit(g); });
+    double t_new = best_of(reps, [&] { b = find_euler_circuit(g); });
+    const bool ok_old = is_euler_circuit(g, a), ok_new = is_euler_circuit(g, b);
+
+    std::printf("graph: n=%zu m=%zu\n", g.n(), g.m());
+    std::printf("%-10s %10.2f ms  %s\n", "legacy", t_old, ok_old ? "valid" : "INVALID");
+    std::printf("%-10s %10.2f ms  %s\n", "edge-ids", t_new, ok_new ? "valid" : "INVALID");
+    return ok_old && ok_new ? 0 : 1;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include "graph.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Result checks shared by the benchmarks (Eulerian inputs come from
+// Graph::random_eulerian).
+
+// True if 'tour' is a closed walk that uses every edge of g exactly once.
+inline bool is_euler_circuit(const Graph& g, const std::vector<std::size_t>& tour) {
+    if (g.m() == 0) return tour.empty();
+    if (tour.size() != g.m() + 1 || tour.front() != tour.back()) return false;
+    std::unordered_map<std::uint64_t, vertex_t> id_of;
+    id_of.reserve(2 * g.m());
+    for (std::size_t u = 0; u < g.n(); ++u) {
+        auto nb = g.neighbors(u);
+        auto ids = g.edge_ids(u);
+        for (std::size_t i = 0; i < nb.size(); ++i) id_of[(static_cast<std::uint64_t>(u) << 32) | nb[i]] = ids[i];
+    }
+    std::vector<char> used(g.m(), 0);
+    for (std::size_t i = 0; i + 1 < tour.size(); ++i) {
+        auto it = id_of.find((static_cast<std::uint64_t>(tour[i]) << 32) | tour[i + 1]);
+        if (it == id_of.end() || used[it->second]) return false;
+        used[it->second] = 1;
+    }
+    return true;
+}
@@ -0,0 +1,116 @@
+// Hamiltonian cycle: the previous HAMILTON implementation (plain recursive
+// backtracking from vertex 0) versus Stage7/hamilton.cpp on graphs of
+// increasing size. The old search is exponential with no pruning, so it runs
+// in a forked child that is killed after -T seconds ("timeout"). Every cycle
+// the new engine returns is checked, and its answer must match the old one
+// whenever that finishes.
+//
+// Families (-g): "random" has average degree -d; "bipartite" is the complete
+// bipartite graph on n/2 and n - n/2 vertices, Hamiltonian for even n and
+// not for odd n (the old search tries every ordering before giving up).
+//
+//   ./bench_hamilton -g random -n 12,16,20,24,28,32,48,64,128,512 -d 6 -T 10 -r 3
+//   ./bench_hamilton -g bipartite -n 9,11,13,15,17,19,21 -T 10 -r 3
+
+#include "graph.hpp"
+#include "hamilton.hpp"
+#include "parallel.hpp"
+#include "bench_util.hpp"
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+// The pre-Held-Karp HamiltonAlg search, unchanged apart from the wrapper.
+static bool old_dfs(const Graph& G, std::vector<int>& path, std::vector<int>& used, int n) {
+    if ((int)path.size() == n) {
+        int u = path.back(), v = path.front();
+        for (size_t x : G.neighbors(u)) if ((int)x == v) return true;
+        return false;
+    }
+    int u = path.back();
+    for (size_t v : G.neighbors(u)) {
+        if (!used[v]) {
+            used[v] = 1; path.push_back((int)v);
+            if (old_dfs(G, path, used, n)) return true;
+            path.pop_back(); used[v] = 0;
+        }
+    }
+    return false;
+}
+
+static bool old_hamilton(const Graph& G) {
+    int n = (int)G.num_vertices();
+    std::vector<int> used(n, 0), path;
+    path.push_back(0); used[0] = 1;
+    return old_dfs(G, path, used, n);
+}
+
+// Runs old_hamilton in a child with a time limit. Returns 1 (cycle),
+// 0 (none) or -1 (timed out), and the wall time in *ms.
+static int old_timed(const Graph& G, unsigned limit_s, double* ms) {
+    Stopwatch sw;
+    const pid_t pid = fork();
+    if (pid == 0) {
+        alarm(limit_s);
+        _exit(old_hamilton(G) ? 1 : 0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    *ms = sw.ms();
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static Graph complete_bipartite(std::size_t n) {
+    const std::size_t left = n / 2;
+    GraphBuilder b(n);
+    for (std::size_t u = 0; u < left; ++u)
+        for (std::size_t v = left; v < n; ++v) b.add_edge(u, v);
+    return *b.build();
+}
+
+static bool is_cycle(const Graph& G, const std::vector<vertex_t>& c) {
+    if (c.size() != G.n() + 1 || c.front() != c.back()) return false;
+    std::vector<char> seen(G.n(), 0);
+    for (std::size_t i = 0; i + 1 < c.size(); ++i) {
+        if (seen[c[i]]) return false;
+        seen[c[i]] = 1;
+        bool edge = false;
+        for (vertex_t x : G.neighbors(c[i])) edge = edge || x == c[i + 1];
+        if (!edge) return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::size_t> sizes;
+    std::istringstream list(arg_str(argc, argv, "-n", "12,16,20,24,28,32,48,64,128,512"));
+    for (std::string t; std::getline(list, t, ',');) sizes.push_back(std::stoull(t));
+    const std::string family = arg_str(argc, argv, "-g", "random");
+    const std::size_t degree = arg_u64(argc, argv, "-d", 6); // m = degree * n / 2
+    const unsigned limit = static_cast<unsigned>(arg_u64(argc, argv, "-T", 10));
+    const unsigned seed = static_cast<unsigned>(arg_u64(argc, argv, "-s", 1));
+    const int reps = static_cast<int>(arg_u64(argc, argv, "-r", 3));
+    const unsigned threads = static_cast<unsigned>(arg_u64(argc, argv, "-t", default_threads()));
+
+    std::printf("%8s %8s %12s %12s %8s\n", "n", "m", "old ms", "new ms", "cycle");
+    for (std::size_t n : sizes) {
+        const Graph G = family == "bipartite" ? complete_bipartite(n)
+                                              : Graph::random_simple(n, degree * n / 2, seed);
+        std::vector<vertex_t> cycle;
+        const double t_new = best_of(reps, [&] { cycle = hamilton_cycle(G, threads); });
+        bool ok = cycle.empty() || is_cycle(G, cycle);
+
+        double t_old = 0;
+        const int old = old_timed(G, limit, &t_old);
+        std::string old_ms = old < 0 ? "timeout" : std::to_string(static_cast<long>(t_old));
+        if (old >= 0 && (old == 1) != !cycle.empty()) ok = false;
+        std::printf("%8zu %8zu %12s %12.2f %8s%s\n", n, G.m(), old_ms.c_str(), t_new, cycle.empty() ? "no" : "yes",
+                    ok ? "" : "  MISMATCH");
+    }
+    return 0;
+}
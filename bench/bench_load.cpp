@@ -0,0 +1,90 @@
+// Text loader throughput: getline/istringstream reader (the previous
+// implementation) versus the mmap scanner, single- and multi-threaded.
+//
+//   ./bench_load -m 100000000 -t 8 -o /tmp/edges.txt     (100M edges, ~1.6 GB)
+//   ./bench_load -m 10000000  -t 4 -k 1                  (reuse existing file)
+
+#include "graph.hpp"
+#include "bench_util.hpp"
+
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+
+// Previous loader: one std::getline + std::istringstream per line.
+static std::optional<Graph> legacy_load(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) return std::nullopt;
+    auto skippable = [](const std::string& l) {
+        if (!l.empty() && l[0] == '#') return true;
+        for (char c : l) if (!std::isspace(static_cast<unsigned char>(c))) return false;
+        return true;
+    };
+    std::string line;
+    std::size_t n = 0, m = 0;
+    while (std::getline(in, line)) {
+        if (skippable(line)) continue;
+        std::istringstream hdr(line);
+        if (!(hdr >> n >> m)) return std::nullopt;
+        break;
+    }
+    GraphBuilder b(n);
+    b.reserve(m);
+    std::size_t added = 0;
+    while (added < m && std::getline(in, line)) {
+        if (skippable(line)) continue;
+        std::istringstream es(line);
+        std::size_t u, v;
+        if (!(es >> u >> v) || !b.add_edge(u, v)) return std::nullopt;
+        ++added;
+    }
+    if (added != m) return std::nullopt;
+    return b.build();
+}
+
+// m unique edges on n = m/8 vertices: u -- (u + k) mod n for k = 1..8.
+static void write_edges(const std::string& path, std::size_t m) {
+    const std::size_t n = std::max<std::size_t>(17, m / 8);
+    std::FILE* f = std::fopen(path.c_str(), "w");
+    std::fprintf(f, "%zu %zu\n", n, m);
+    std::size_t written = 0;
+    for (std::size_t k = 1; written < m; ++k)
+        for (std::size_t u = 0; u < n && written < m; ++u, ++written)
+            std::fprintf(f, "%zu %zu\n", u, (u + k) % n);
+    std::fclose(f);
+}
+
+int main(int argc, char** argv) {
+    const std::size_t m = arg_u64(argc, argv, "-m", 10000000);
+    const unsigned threads = static_cast<unsigned>(arg_u64(argc, argv, "-t", 4));
+    const bool keep = arg_u64(argc, argv, "-k", 0) != 0;
+    std::string path = "/tmp/bench_load_edges.txt";
+    for (int i = 1; i + 1 < argc; ++i) if (std::string(argv[i]) == "-o") path = argv[i + 1];
+
+    struct stat st{};
+    if (!keep || ::stat(path.c_str(), &st) != 0) {
+        Stopwatch sw;
+        write_edges(path, m);
+        std::printf("generated %s in %.0f ms\n", path.c_str(), sw.ms());
+    }
+    ::stat(path.c_str(), &st);
+    const double mb = static_cast<double>(st.st_size) / 1e6;
+
+    auto report = [&](const char* name, auto&& load) {
+        Stopwatch sw;
+        std::optional<Graph> g = load();
+        const double t = sw.ms();
+        std::printf("%-14s %10.0f ms %10.1f MB/s  %s\n", name, t, mb / (t / 1000.0), g ? "ok" : "FAILED");
+    };
+
+    std::printf("file: %.1f MB, %zu edges\n", mb, m);
+    report("getline", [&] { return legacy_load(path); });
+    report("mmap x1", [&] { return Graph::load_from_file(path, nullptr, 1); });
+    std::string name = "mmap x" + std::to_string(threads);
+    report(name.c_str(), [&] { return Graph::load_from_file(path, nullptr, threads); });
+    return 0;
+}
@@ -0,0 +1,105 @@
+// Max flow from 0 to n-1: the previous MAXFLOW implementation (Edmonds-Karp
+// on an n x n capacity matrix, unit capacities) versus Dinic on the CSR
+// residual graph (Stage7/max_flow.cpp). The matrix version only runs while
+// its n^2 ints fit -L MiB; larger sizes report Dinic alone, once with unit
+// capacities and once with random capacities in [1, -w].
+//
+//   ./bench_maxflow -n 500,1000,2000,4000,100000,1000000 -d 5 -w 100 -r 3
+
+#include "graph.hpp"
+#include "max_flow.hpp"
+#include "bench_util.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+// The pre-Dinic MaxFlowAlg::run, minus the reply formatting.
+static int matrix_edmonds_karp(const Graph& G) {
+    size_t n = G.num_vertices();
+    std::vector<std::vector<int>> cap(n, std::vector<int>(n, 0));
+
+    for (size_t u = 0; u < n; u++)
+        for (size_t v : G.neighbors(u))
+            cap[u][v] = 1;
+
+    int s = 0, t = (int)n - 1;
+    int flow = 0;
+
+    while (true) {
+        std::vector<int> par(n, -1);
+        std::queue<int> q; q.push(s); par[s] = s;
+        while (!q.empty() && par[t] == -1) {
+            int u = q.front(); q.pop();
+            for (int v = 0; v < (int)n; v++) if (par[v] == -1 && cap[u][v] > 0) {
+                par[v] = u; q.push(v);
+            }
+        }
+        if (par[t] == -1) break;
+
+        int aug = 1e9;
+        for (int v = t; v != s; v = par[v]) aug = std::min(aug, cap[par[v]][v]);
+        for (int v = t; v != s; v = par[v]) {
+            cap[par[v]][v] -= aug;
+            cap[v][par[v]] += aug;
+        }
+        flow += aug;
+    }
+    return flow;
+}
+
+// Same edges as G, each with a capacity drawn from [1, wmax].
+static Graph with_random_weights(const Graph& G, weight_t wmax, unsigned seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<weight_t> dist(1, wmax);
+    GraphBuilder b(G.n());
+    b.reserve(G.m());
+    for (std::size_t u = 0; u < G.n(); ++u)
+        for (std::size_t v : G.neighbors(u))
+            if (u < v) b.add_edge(u, v, dist(rng));
+    return std::move(*b.build());
+}
+
+static std::vector<std::size_t> parse_list(const std::string& s) {
+    std::vector<std::size_t> out;
+    for (std::size_t i = 0; i < s.size();) {
+        std::size_t j = std::min(s.find(',', i), s.size());
+        out.push_back(std::stoull(s.substr(i, j - i)));
+        i = j + 1;
+    }
+    return out;
+}
+
+int main(int argc, char** argv) {
+    const auto sizes = parse_list(arg_str(argc, argv, "-n", "500,1000,2000,4000,100000,1000000"));
+    const std::size_t degree = arg_u64(argc, argv, "-d", 5); // m = degree * n
+    const weight_t wmax = static_cast<weight_t>(arg_u64(argc, argv, "-w", 100));
+    const std::size_t limit_mib = arg_u64(argc, argv, "-L", 256);
+    const unsigned seed = static_cast<unsigned>(arg_u64(argc, argv, "-s", 1));
+    const int reps = static_cast<int>(arg_u64(argc, argv, "-r", 3));
+
+    std::printf("%10s %10s %12s %10s %10s %10s %8s %10s\n", "n", "m", "matrix MiB", "matrix ms", "dinic ms",
+                "dinic w ms", "flow", "w flow");
+    for (std::size_t n : sizes) {
+        const Graph G = Graph::random_simple(n, degree * n, seed);
+        const Graph W = with_random_weights(G, wmax, seed);
+        const double matrix_mib = mib(n * n * sizeof(int));
+
+        weight_t flow = 0, wflow = 0;
+        const double dinic = best_of(reps, [&] { flow = max_flow(G, 0, n - 1); });
+        const double dinic_w = best_of(reps, [&] { wflow = max_flow(W, 0, n - 1); });
+
+        std::string matrix = "-";
+        if (matrix_mib <= static_cast<double>(limit_mib)) {
+            int old = 0;
+            const double t = best_of(reps, [&] { old = matrix_edmonds_karp(G); });
+            matrix = old == flow ? std::to_string(static_cast<long>(t)) : "MISMATCH";
+        }
+        std::printf("%10zu %10zu %12.1f %10s %10.1f %10.1f %8lld %10lld\n", n, G.m(), matrix_mib, matrix.c_str(),
+                    dinic, dinic_w, static_cast<long long>(flow), static_cast<long long>(wflow));
+    }
+    return 0;
+}
@@ -0,0 +1,107 @@
+// Minimum spanning forest: the previous MST implementation (Kruskal in
+// adjacency order over a union-find without path compression or union by
+// rank, unit weights only) versus Kruskal with radix-sorted weights and a
+// proper union-find, and parallel Boruvka at 1/2/4/8 threads (or -T).
+// The old version only runs up to -L edges (its finds degrade to O(n)).
+// The new engines run on random weights in [1, -w]; every total is checked
+// against Kruskal's.
+//
+//   ./bench_mst -n 20000,1000000,4000000 -d 5 -w 1000 -L 200000 -r 3
+
+#include "graph.hpp"
+#include "mst.hpp"
+#include "bench_util.hpp"
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// The pre-weights MstWeightAlg::run, minus the reply formatting.
+static int old_mst(const Graph& G) {
+    size_t n = G.num_vertices();
+
+    struct Edge { size_t u, v; int w; };
+    std::vector<Edge> edges;
+    for (size_t u = 0; u < n; ++u) {
+        for (size_t v : G.neighbors(u)) {
+            if (u < v) edges.push_back({u, v, 1});
+        }
+    }
+
+    std::vector<size_t> p(n);
+    for (size_t i = 0; i < n; i++) p[i] = i;
+
+    auto find = [&](size_t x) {
+        while (p[x] != x) x = p[x];
+        return x;
+    };
+    auto unite = [&](size_t a, size_t b) {
+        a = find(a); b = find(b);
+        if (a != b) p[a] = b;
+    };
+
+    int total = 0;
+    for (auto &e : edges) {
+        if (find(e.u) != find(e.v)) {
+            unite(e.u, e.v);
+            total += e.w;
+        }
+    }
+    return total;
+}
+
+static std::vector<unsigned> parse_list(const std::string& s) {
+    std::vector<unsigned> out;
+    std::istringstream in(s);
+    for (std::string t; std::getline(in, t, ',');) out.push_back(static_cast<unsigned>(std::stoul(t)));
+    return out;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::size_t> sizes;
+    std::istringstream list(arg_str(argc, argv, "-n", "20000,1000000,4000000"));
+    for (std::string t; std::getline(list, t, ',');) sizes.push_back(std::stoull(t));
+    const std::size_t degree = arg_u64(argc, argv, "-d", 5); // m = degree * n
+    const weight_t wmax = static_cast<weight_t>(arg_u64(argc, argv, "-w", 1000));
+    const std::size_t limit = arg_u64(argc, argv, "-L", 200000);
+    const unsigned seed = static_cast<unsigned>(arg_u64(argc, argv, "-s", 1));
+    const int reps = static_cast<int>(arg_u64(argc, argv, "-r", 3));
+    const auto counts = parse_list(arg_str(argc, argv, "-T", "1,2,4,8"));
+
+    bool all_ok = true;
+    for (std::size_t n : sizes) {
+        const Graph U = Graph::random_simple(n, degree * n, seed);
+        const Graph W = U.with_weights(Graph::random_weights(U.m(), 1, wmax, seed));
+        std::printf("graph: n=%zu m=%zu\n", U.n(), U.m());
+
+        // Unit weights: old vs. new Kruskal
+        MstResult r;
+        const double kru_u = best_of(reps, [&] { r = mst_kruskal(U, false); });
+        if (U.m() <= limit) {
+            int old = 0;
+            const double t = best_of(reps, [&] { old = old_mst(U); });
+            const bool ok = old == r.total;
+            all_ok = all_ok && ok;
+            std::printf("  %-18s %10.1f ms  total %lld  %s\n", "old (unit)", t, static_cast<long long>(old),
+                        ok ? "ok" : "MISMATCH");
+        } else {
+            std::printf("  %-18s %10s     (m > -L)\n", "old (unit)", "-");
+        }
+        std::printf("  %-18s %10.1f ms  total %lld\n", "kruskal (unit)", kru_u, static_cast<long long>(r.total));
+
+        // Random weights: Kruskal vs. Boruvka
+        MstResult k;
+        const double kru_w = best_of(reps, [&] { k = mst_kruskal(W, false); });
+        std::printf("  %-18s %10.1f ms  total %lld\n", "kruskal (w)", kru_w, static_cast<long long>(k.total));
+        for (unsigned t : counts) {
+            MstResult b;
+            const double ms = best_of(reps, [&] { b = mst_boruvka(W, t, false); });
+            const bool ok = b.total == k.total && b.edges == k.edges;
+            all_ok = all_ok && ok;
+            std::printf("  boruvka x%-9u %10.1f ms  total %lld  %s\n", t, ms, static_cast<long long>(b.total),
+                        ok ? "ok" : "MISMATCH");
+        }
+    }
+    return all_ok ? 0 : 1;
+}
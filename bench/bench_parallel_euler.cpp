@@ -0,0 +1,45 @@
+// Speedup of find_euler_circuit_parallel over the serial find_euler_circuit
+// at 1/2/4/8/16 threads (or the list given with -T). Every circuit is validated.
+//
+//   ./bench_parallel_euler -n 4000000 -m 40000000 -s 1 -r 3
+
+#include "graph.hpp"
+#include "euler.hpp"
+#include "bench_util.hpp"
+#include "bench_graphs.hpp"
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv) {
+    const std::size_t n = arg_u64(argc, argv, "-n", 500000);
+    const std::size_t m = arg_u64(argc, argv, "-m", 5000000);
+    const unsigned seed = static_cast<unsigned>(arg_u64(argc, argv, "-s", 1));
+    const int reps = static_cast<int>(arg_u64(argc, argv, "-r", 3));
+    std::vector<unsigned> counts{1, 2, 4, 8, 16};
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) != "-T") continue;
+        counts.clear();
+        std::istringstream in(argv[i + 1]);
+        for (std::string t; std::getline(in, t, ',');) counts.push_back(static_cast<unsigned>(std::stoul(t)));
+    }
+
+    Graph g = Graph::random_eulerian(n, m, seed);
+    std::printf("graph: n=%zu m=%zu\n", g.n(), g.m());
+
+    std::vector<std::size_t> tour;
+    const double serial = best_of(reps, [&] { tour = find_euler_circuit(g); });
+    std::printf("%-8s %10.2f ms %8s  %s\n", "serial", serial, "1.00x", is_euler_circuit(g, tour) ? "valid" : "INVALID");
+
+    bool all_ok = true;
+    for (unsigned t : counts) {
+        // t == 1 takes the serial fallback, i.e. measures the dispatch only
+        const double ms = best_of(reps, [&] { tour = find_euler_circuit_parallel(g, t); });
+        const bool ok = is_euler_circuit(g, tour);
+        all_ok = all_ok && ok;
+        std::printf("x%-7u %10.2f ms %7.2fx  %s\n", t, ms, serial / ms, ok ? "valid" : "INVALID");
+    }
+    return all_ok ? 0 : 1;
+}
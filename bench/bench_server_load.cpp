@@ -0,0 +1,110 @@
+// Load generator for alg_server (or any server speaking one request per
+// connection, answered by "...END\n" and a close). -c client threads each
+// send requests back to back until -N requests are done in total; reports
+// throughput and latency percentiles. Every k-th request (-k) can be
+// replaced by a slow one (-S) to show head-of-line blocking: compare the
+// epoll server against the iterative one built from an older checkout.
+// -C 1,4,16,64 repeats the run at each client count (one row per level),
+// e.g. to compare "alg_server -m lf -t 8" with a single-threaded "-t 1".
+//
+//   ./bench_server_load -p 5555 -c 64 -N 20000 -q "ALG MST RAND 1000 5000 1"
+//   ./bench_server_load -p 5555 -c 64 -N 2000 -S "ALG HAMILTON RAND 40 200 1" -k 100
+//   ./bench_server_load -p 5555 -C 1,4,16,64 -N 2000 -q "ALG MST RAND 20000 100000 1"
+
+#include "bench_util.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// One request on a fresh connection; true if the reply ended with "END\n".
+static bool one_request(const sockaddr_in& addr, const std::string& req) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    bool ok = ::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0 &&
+              ::send(fd, req.data(), req.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(req.size());
+    std::string tail;
+    char buf[1 << 16];
+    for (ssize_t r; ok && (r = ::recv(fd, buf, sizeof(buf), 0)) > 0;) {
+        tail.append(buf, static_cast<std::size_t>(r));
+        if (tail.size() > 8) tail.erase(0, tail.size() - 8);
+    }
+    ::close(fd);
+    return ok && tail.size() >= 4 && tail.compare(tail.size() - 4, 4, "END\n") == 0;
+}
+
+struct Result {
+    double secs;
+    std::size_t failed;
+    std::vector<double> lat; // fast requests, sorted, ms
+};
+
+static Result run(const sockaddr_in& addr, unsigned clients, std::size_t total, const std::string& fast,
+                  const std::string& slow, std::size_t every) {
+    std::atomic<std::size_t> next{0}, failed{0};
+    std::vector<std::vector<double>> lat(clients);
+    Stopwatch wall;
+    std::vector<std::thread> pool;
+    for (unsigned c = 0; c < clients; ++c) {
+        pool.emplace_back([&, c] {
+            for (std::size_t i; (i = next.fetch_add(1)) < total;) {
+                const bool is_slow = !slow.empty() && every && i % every == 0;
+                Stopwatch sw;
+                if (!one_request(addr, is_slow ? slow + "\n" : fast)) ++failed;
+                if (!is_slow) lat[c].push_back(sw.ms());
+            }
+        });
+    }
+    for (auto& t : pool) t.join();
+
+    Result r{wall.ms() / 1000.0, failed.load(), {}};
+    for (auto& v : lat) r.lat.insert(r.lat.end(), v.begin(), v.end());
+    std::sort(r.lat.begin(), r.lat.end());
+    return r;
+}
+
+static double pct(const std::vector<double>& v, double p) {
+    return v.empty() ? 0.0 : v[std::min(v.size() - 1, static_cast<std::size_t>(p * static_cast<double>(v.size())))];
+}
+
+int main(int argc, char** argv) {
+    const unsigned port = static_cast<unsigned>(arg_u64(argc, argv, "-p", 5555));
+    const std::size_t total = arg_u64(argc, argv, "-N", 10000);
+    const std::string fast = arg_str(argc, argv, "-q", "ALG MST RAND 1000 5000 1") + "\n";
+    const std::string slow = arg_str(argc, argv, "-S", "");
+    const std::size_t every = arg_u64(argc, argv, "-k", 0);
+    std::vector<unsigned> levels{static_cast<unsigned>(arg_u64(argc, argv, "-c", 32))};
+    const std::string sweep = arg_str(argc, argv, "-C", "");
+    if (!sweep.empty()) {
+        levels.clear();
+        std::istringstream in(sweep);
+        for (std::string t; std::getline(in, t, ',');) levels.push_back(static_cast<unsigned>(std::stoul(t)));
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    std::size_t failed = 0;
+    std::printf("%8s %8s %12s %10s %10s %10s %7s\n", "clients", "requests", "req/s", "p50 ms", "p99 ms", "max ms",
+                "failed");
+    for (unsigned clients : levels) {
+        const Result r = run(addr, clients ? clients : 1, total, fast, slow, every);
+        std::printf("%8u %8zu %12.1f %10.2f %10.2f %10.2f %7zu\n", clients, total,
+                    static_cast<double>(total) / r.secs, pct(r.lat, 0.50), pct(r.lat, 0.99),
+                    r.lat.empty() ? 0.0 : r.lat.back(), r.failed);
+        failed += r.failed;
+    }
+    std::printf("(latencies are for fast requests only)\n");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,263 @@
+// Reproducible benchmark suite: every operation the servers time-share,
+// over a sweep of sizes and densities, written as JSON so runs from two
+// commits can be diffed with compare.py (make bench; make compare).
+//
+//  - gen/random_simple, gen/random_eulerian     Graph generators
+//  - load/text, load/text_mt                    Graph::load_from_file, 1 and -t threads
+//  - euler/feasibility, euler/circuit           Stage2 on a random Eulerian graph
+//  - mst/kruskal, mst/boruvka                   weights in [1, 1000]
+//  - scc/tarjan, scc/union_find                 components, counted by a sink
+//  - maxflow/dinic                              0 -> n-1, capacities = weights
+//  - hamilton/search                            random graphs of average degree 10, -H sizes
+//
+// Every case runs for each n in -n and m = d * n for each d in -d, seeded,
+// so the inputs are identical across runs. A case records min / median /
+// mean / max wall time over -r repetitions and a result string (circuit
+// length, MST weight, ...) that must not change between commits.
+//
+//   ./bench_suite -n 10000,100000,1000000 -d 2,8 -H 16,24,64,512 -r 3 -o run.json
+//   ./bench_suite -f mst/ -n 4000000 -d 4        (only names containing "mst/")
+
+#include "graph.hpp"
+#include "euler.hpp"
+#include "max_flow.hpp"
+#include "mst.hpp"
+#include "components.hpp"
+#include "hamilton.hpp"
+#include "parallel.hpp"
+#include "bench_util.hpp"
+
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Result {
+    std::string name, group;
+    std::size_t n, m;
+    unsigned threads;
+    std::vector<double> ms; // one per repetition
+    std::string value;      // what the run computed, to compare across commits
+};
+
+std::string json_string(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        if (static_cast<unsigned char>(c) < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+std::string cpu_model() {
+    std::ifstream in("/proc/cpuinfo");
+    for (std::string line; std::getline(in, line);)
+        if (line.rfind("model name", 0) == 0) {
+            const auto colon = line.find(':');
+            return colon == std::string::npos ? line : line.substr(line.find_first_not_of(' ', colon + 1));
+        }
+    return "unknown";
+}
+
+// Machine and build the numbers came from.
+std::string context_json(const std::string& label, int reps, unsigned threads) {
+    char host[256] = "unknown";
+    ::gethostname(host, sizeof(host) - 1);
+    utsname un{};
+    ::uname(&un);
+    char date[32];
+    const std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    std::string out = "{\n";
+    out += "    \"label\": " + json_string(label) + ",\n";
+    out += "    \"date\": " + json_string(date) + ",\n";
+    out += "    \"host\": " + json_string(host) + ",\n";
+    out += "    \"os\": " + json_string(std::string(un.sysname) + " " + un.release + " " + un.machine) + ",\n";
+    out += "    \"cpu\": " + json_string(cpu_model()) + ",\n";
+    out += "    \"num_cpus\": " + std::to_string(std::thread::hardware_concurrency()) + ",\n";
+    out += "    \"threads\": " + std::to_string(threads) + ",\n";
+    out += "    \"compiler\": " + json_string("g++ " __VERSION__) + ",\n";
+#ifdef __OPTIMIZE__
+    out += "    \"optimized\": true,\n";
+#else
+    out += "    \"optimized\": false,\n";
+#endif
+    out += "    \"repetitions\": " + std::to_string(reps) + "\n  }";
+    return out;
+}
+
+std::string result_json(const Result& r) {
+    std::vector<double> sorted = r.ms;
+    std::sort(sorted.begin(), sorted.end());
+    double sum = 0;
+    for (double t : sorted) sum += t;
+    const double median = sorted.size() % 2 ? sorted[sorted.size() / 2]
+                                            : (sorted[sorted.size() / 2 - 1] + sorted[sorted.size() / 2]) / 2;
+    char buf[512];
+    std::snprintf(buf, sizeof(buf),
+                  "{\"name\": %s, \"group\": %s, \"n\": %zu, \"m\": %zu, \"threads\": %u, \"min_ms\": %.4f, "
+                  "\"median_ms\": %.4f, \"mean_ms\": %.4f, \"max_ms\": %.4f, \"edges_per_s\": %.0f, \"result\": %s}",
+                  json_string(r.name).c_str(), json_string(r.group).c_str(), r.n, r.m, r.threads, sorted.front(),
+                  median, sum / static_cast<double>(sorted.size()), sorted.back(),
+                  sorted.front() > 0 ? static_cast<double>(r.m) / (sorted.front() / 1e3) : 0.0,
+                  json_string(r.value).c_str());
+    return buf;
+}
+
+// Runs the cases the filter selects, printing a line per case to stderr.
+class Suite {
+public:
+    Suite(int reps, std::string filter) : m_reps(reps), m_filter(std::move(filter)) {}
+
+    // Time 'run', which returns its result string.
+    void add(const std::string& group, const std::string& op, std::size_t n, std::size_t m, unsigned threads,
+             const std::function<std::string()>& run) {
+        Result r{group + "/" + op + "/n:" + std::to_string(n) + "/m:" + std::to_string(m), group, n, m, threads, {}, {}};
+        if (r.name.find(m_filter) == std::string::npos) return;
+        for (int i = 0; i < m_reps; ++i) {
+            Stopwatch sw;
+            r.value = run();
+            r.ms.push_back(sw.ms());
+        }
+        std::fprintf(stderr, "%-44s %12.2f ms  %s\n", r.name.c_str(), *std::min_element(r.ms.begin(), r.ms.end()),
+                     r.value.c_str());
+        m_results.push_back(std::move(r));
+    }
+
+    const std::vector<Result>& results() const { return m_results; }
+
+private:
+    int m_reps;
+    std::string m_filter;
+    std::vector<Result> m_results;
+};
+
+void write_text(const Graph& G, const std::string& path) {
+    std::FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) { std::perror(path.c_str()); std::exit(1); }
+    std::fprintf(f, "%zu %zu\n", G.n(), G.m());
+    for (std::size_t u = 0; u < G.n(); ++u) {
+        const auto nbrs = G.neighbors(u);
+        const auto eids = G.edge_ids(u);
+        for (std::size_t i = 0; i < nbrs.size(); ++i)
+            if (u < nbrs[i])
+                std::fprintf(f, "%zu %zu %lld\n", u, static_cast<std::size_t>(nbrs[i]),
+                             static_cast<long long>(G.weight(eids[i])));
+    }
+    std::fclose(f);
+}
+
+// Vertex count of the components 'each' finds, and how many there are.
+std::string count_components(const std::function<bool(const ComponentSink&)>& each) {
+    std::size_t components = 0, vertices = 0;
+    each([&](const vertex_t*, std::size_t count) {
+        ++components;
+        vertices += count;
+        return true;
+    });
+    return std::to_string(components) + " components, " + std::to_string(vertices) + " vertices";
+}
+
+void run_sweep(Suite& suite, std::size_t n, std::size_t m, unsigned threads, const std::string& tmp) {
+    Graph G(0), E(0);
+    suite.add("gen", "random_simple", n, m, 1, [&] {
+        G = Graph::random_simple(n, m, 1);
+        return std::to_string(G.m()) + " edges";
+    });
+    suite.add("gen", "random_eulerian", n, m, 1, [&] {
+        E = Graph::random_eulerian(n, m, 1);
+        return std::to_string(E.m()) + " edges";
+    });
+    // Filtered-out generators leave nothing to run on
+    if (G.n() != n) G = Graph::random_simple(n, m, 1);
+    if (E.n() != n) E = Graph::random_eulerian(n, m, 1);
+    const Graph W = G.with_weights(Graph::random_weights(G.m(), 1, 1000, 1));
+
+    write_text(W, tmp);
+    for (unsigned t : {1u, threads}) {
+        suite.add("load", t == 1 ? "text" : "text_mt", n, m, t, [&] {
+            auto loaded = Graph::load_from_file(tmp, nullptr, t);
+            return loaded ? std::to_string(loaded->m()) + " edges" : std::string("load failed");
+        });
+        if (threads == 1) break;
+    }
+    std::remove(tmp.c_str());
+
+    suite.add("euler", "feasibility", n, E.m(), 1, [&] {
+        const EulerCheck c = euler_feasibility(E);
+        return c.ok ? std::string("ok") : c.reason;
+    });
+    suite.add("euler", "circuit", n, E.m(), 1,
+              [&] { return std::to_string(find_euler_circuit(E).size()) + " vertices in circuit"; });
+
+    suite.add("mst", "kruskal", n, W.m(), 1,
+              [&] { return "weight " + std::to_string(mst_kruskal(W, false).total); });
+    suite.add("mst", "boruvka", n, W.m(), threads,
+              [&] { return "weight " + std::to_string(mst_boruvka(W, threads, false).total); });
+
+    suite.add("scc", "tarjan", n, G.m(), 1,
+              [&] { return count_components([&](const ComponentSink& s) { return for_each_scc(G, s); }); });
+    suite.add("scc", "union_find", n, G.m(), threads, [&] {
+        return count_components([&](const ComponentSink& s) { return for_each_component(G, s, threads); });
+    });
+
+    if (n >= 2)
+        suite.add("maxflow", "dinic", n, W.m(), 1, [&] { return "flow " + std::to_string(max_flow(W, 0, n - 1)); });
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const auto sizes = arg_list(argc, argv, "-n", "10000,100000,1000000");
+    const auto degrees = arg_list(argc, argv, "-d", "2,8");
+    const auto hamilton_sizes = arg_list(argc, argv, "-H", "16,24,64,512");
+    const int reps = static_cast<int>(arg_u64(argc, argv, "-r", 3));
+    const unsigned threads = static_cast<unsigned>(arg_u64(argc, argv, "-t", default_threads()));
+    const std::string out_path = arg_str(argc, argv, "-o", "");
+    const std::string label = arg_str(argc, argv, "-label", "");
+    const std::string tmp = arg_str(argc, argv, "-tmp", "/tmp") + "/bench_suite_" + std::to_string(::getpid()) + ".txt";
+    Suite suite(reps > 0 ? reps : 1, arg_str(argc, argv, "-f", ""));
+
+    for (std::size_t n : sizes)
+        for (std::size_t d : degrees) run_sweep(suite, n, d * n, threads, tmp);
+
+    for (std::size_t n : hamilton_sizes) {
+        const Graph H = Graph::random_simple(n, 5 * n, 1);
+        suite.add("hamilton", "search", n, H.m(), threads, [&] {
+            const auto cycle = hamilton_cycle(H, threads);
+            return cycle.empty() ? std::string("no cycle") : std::to_string(cycle.size()) + " vertices in cycle";
+        });
+    }
+
+    std::string json = "{\n  \"context\": " + context_json(label, reps, threads) + ",\n  \"benchmarks\": [";
+    const auto& results = suite.results();
+    for (std::size_t i = 0; i < results.size(); ++i) json += (i ? ",\n    " : "\n    ") + result_json(results[i]);
+    json += "\n  ]\n}\n";
+
+    if (out_path.empty()) {
+        std::fputs(json.c_str(), stdout);
+        return 0;
+    }
+    std::FILE* f = std::fopen(out_path.c_str(), "w");
+    if (!f || std::fputs(json.c_str(), f) < 0 || std::fclose(f) != 0) {
+        std::perror(out_path.c_str());
+        return 1;
+    }
+    std::fprintf(stderr, "wrote %zu results to %s\n", results.size(), out_path.c_str());
+    return 0;
+}
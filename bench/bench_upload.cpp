@@ -0,0 +1,145 @@
+// FILE upload parsing throughput on a socket: the previous one-byte
+// recv_line + istringstream tokenizer versus the buffered LineReader with
+// in-place number parsing. A writer thread streams "EULER FILE\nn m\n<edges>
+// END\n" over a socketpair; the reader parses it into a GraphBuilder (the
+// final build() is not timed, it is the same for both).
+//
+//   ./bench_upload -m 1000000 -r 3
+//   ./bench_upload -m 10000000 -r 1 -L 0     (skip the slow legacy reader)
+
+#include "graph.hpp"
+#include "line_reader.hpp"
+#include "bench_util.hpp"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Previous server input path: one recv() per byte, tokens via istringstream.
+static bool legacy_recv_line(int fd, std::string& line) {
+    line.clear();
+    char c;
+    while (true) {
+        ssize_t r = ::recv(fd, &c, 1, 0);
+        if (r <= 0) return false;
+        if (c == '\n') break;
+        line.push_back(c);
+    }
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    return true;
+}
+
+static std::vector<std::string> legacy_split_ws(const std::string& s) {
+    std::istringstream is(s);
+    std::vector<std::string> out;
+    std::string t;
+    while (is >> t) out.push_back(t);
+    return out;
+}
+
+static bool legacy_read(int fd) {
+    std::string line;
+    if (!legacy_recv_line(fd, line) || !legacy_recv_line(fd, line)) return false;
+    auto nm = legacy_split_ws(line);
+    if (nm.size() != 2) return false;
+    const std::size_t n = std::stoul(nm[0]), m = std::stoul(nm[1]);
+    GraphBuilder b(n);
+    b.reserve(m);
+    for (std::size_t i = 0; i < m; ++i) {
+        if (!legacy_recv_line(fd, line)) return false;
+        auto uv = legacy_split_ws(line);
+        if (uv.size() != 2 || !b.add_edge(std::stoul(uv[0]), std::stoul(uv[1]))) return false;
+    }
+    return legacy_recv_line(fd, line) && line == "END";
+}
+
+// Current server input path.
+static bool buffered_read(int fd) {
+    LineReader in(fd, /*socket=*/true);
+    std::string_view line;
+    std::size_t nm[2];
+    if (!in.next(line) || !in.next(line) || !parse_fields(line, nm, 2)) return false;
+    GraphBuilder b(nm[0]);
+    b.reserve(nm[1]);
+    for (std::size_t i = 0; i < nm[1]; ++i) {
+        std::size_t uv[2];
+        if (!in.next(line) || !parse_fields(line, uv, 2) || !b.add_edge(uv[0], uv[1])) return false;
+    }
+    return in.next(line) && line == "END";
+}
+
+// m unique edges on n = m/8 vertices: u -- (u + k) mod n for k = 1..8.
+static std::string make_upload(std::size_t m) {
+    const std::size_t n = std::max<std::size_t>(17, m / 8);
+    std::string s = "EULER FILE\n" + std::to_string(n) + " " + std::to_string(m) + "\n";
+    s.reserve(s.size() + m * 16);
+    std::size_t written = 0;
+    for (std::size_t k = 1; written < m; ++k)
+        for (std::size_t u = 0; u < n && written < m; ++u, ++written) {
+            s += std::to_string(u);
+            s += ' ';
+            s += std::to_string((u + k) % n);
+            s += '\n';
+        }
+    s += "END\n";
+    return s;
+}
+
+// Time one upload of 'payload' parsed by 'reader'; false if it failed.
+template <typename R>
+static bool timed_upload(const std::string& payload, R&& reader, double& ms) {
+    int sv[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0) return false;
+    Stopwatch sw;
+    std::thread writer([&] {
+        const char* p = payload.data();
+        std::size_t left = payload.size();
+        while (left) {
+            ssize_t w = ::send(sv[0], p, std::min<std::size_t>(left, 1 << 16), MSG_NOSIGNAL);
+            if (w <= 0) break;
+            p += w;
+            left -= static_cast<std::size_t>(w);
+        }
+        ::shutdown(sv[0], SHUT_WR);
+    });
+    const bool ok = reader(sv[1]);
+    ::close(sv[1]); // unblocks the writer if the reader gave up early
+    writer.join();
+    ms = sw.ms();
+    ::close(sv[0]);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    const std::size_t m = arg_u64(argc, argv, "-m", 1000000);
+    const int reps = static_cast<int>(arg_u64(argc, argv, "-r", 3));
+    const bool legacy = arg_u64(argc, argv, "-L", 1) != 0;
+
+    const std::string payload = make_upload(m);
+    const double mb = static_cast<double>(payload.size()) / 1e6;
+    std::printf("upload: %.1f MB, %zu edges\n", mb, m);
+
+    // 'calls' is the number of recv() calls one upload needs
+    auto report = [&](const char* name, auto&& reader, std::size_t calls) {
+        double best = 1e300;
+        bool ok = true;
+        for (int i = 0; i < reps; ++i) {
+            double t = 0;
+            ok = timed_upload(payload, reader, t) && ok;
+            best = std::min(best, t);
+        }
+        std::printf("%-10s %10.0f ms %10.1f MB/s %12zu recv calls  %s\n", name, best, mb / (best / 1000.0),
+                    calls, ok ? "ok" : "FAILED");
+    };
+
+    if (legacy) report("recv(1)", legacy_read, payload.size());
+    // One recv per 64 KiB buffer fill at best
+    report("buffered", buffered_read, (payload.size() + (1 << 16) - 1) >> 16);
+    return 0;
+}
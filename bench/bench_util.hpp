@@ -0,0 +1,59 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Small helpers shared by the micro-benchmarks in this directory.
+
+// Wall-clock stopwatch in milliseconds.
+class Stopwatch {
+public:
+    Stopwatch() : t0(std::chrono::steady_clock::now()) {}
+    double ms() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    }
+    void reset() { t0 = std::chrono::steady_clock::now(); }
+private:
+    std::chrono::steady_clock::time_point t0;
+};
+
+// Run f() `reps` times and return the best wall time in milliseconds.
+template <typename F>
+double best_of(int reps, F&& f) {
+    double best = 1e300;
+    for (int i = 0; i < reps; ++i) {
+        Stopwatch sw;
+        f();
+        double t = sw.ms();
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+// Parse "-key value" style integer arguments: arg_u64(argc, argv, "-n", 1000).
+inline unsigned long long arg_u64(int argc, char** argv, const char* key, unsigned long long def) {
+    for (int i = 1; i + 1 < argc; ++i)
+        if (std::string(argv[i]) == key) return std::strtoull(argv[i + 1], nullptr, 10);
+    return def;
+}
+
+// Same for string arguments: arg_str(argc, argv, "-q", "ALG MST RAND 1000 5000 1").
+inline std::string arg_str(int argc, char** argv, const char* key, const char* def) {
+    for (int i = 1; i + 1 < argc; ++i)
+        if (std::string(argv[i]) == key) return argv[i + 1];
+    return def;
+}
+
+// Comma-separated numbers: arg_list(argc, argv, "-n", "1000,100000").
+inline std::vector<std::size_t> arg_list(int argc, char** argv, const char* key, const char* def) {
+    std::vector<std::size_t> out;
+    std::istringstream in(arg_str(argc, argv, key, def));
+    for (std::string t; std::getline(in, t, ',');)
+        if (!t.empty()) out.push_back(std::stoull(t));
+    return out;
+}
+
+inline double mib(std::size_t bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); }
@@ -0,0 +1,135 @@
+// End-to-end latency of one Euler circuit request over loopback, text FILE
+// upload versus the binary protocol (Stage6/binary_protocol.hpp), against a
+// running euler_server (or alg_server with -a EULER). Each request sends a
+// random Eulerian graph and reads the whole reply; circuits are validated
+// outside the timed region.
+//
+//   ./bench_wire -p 5555 -n 1000000 -m 10000000 -r 3
+//   ./bench_wire -p 5556 -a EULER -n 1000000 -m 10000000 -r 3     (alg_server)
+
+#include "graph.hpp"
+#include "binary_protocol.hpp"
+#include "bench_graphs.hpp"
+#include "bench_util.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Send 'req', half-close, and read until the server closes.
+static bool round_trip(const sockaddr_in& addr, const std::string& req, std::string& reply) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0) return false;
+    bool ok = true;
+    for (std::size_t off = 0; ok && off < req.size();) {
+        ssize_t w = ::send(fd, req.data() + off, req.size() - off, MSG_NOSIGNAL);
+        ok = w > 0;
+        off += ok ? static_cast<std::size_t>(w) : 0;
+    }
+    ::shutdown(fd, SHUT_WR);
+    reply.clear();
+    char buf[1 << 16];
+    for (ssize_t r; (r = ::recv(fd, buf, sizeof(buf), 0)) > 0;) reply.append(buf, static_cast<std::size_t>(r));
+    ::close(fd);
+    return ok;
+}
+
+// Each edge once (u < v), in adjacency order.
+static std::vector<std::pair<std::size_t, std::size_t>> edge_list(const Graph& G) {
+    std::vector<std::pair<std::size_t, std::size_t>> e;
+    e.reserve(G.m());
+    for (std::size_t u = 0; u < G.n(); ++u)
+        for (std::size_t v : G.neighbors(u))
+            if (u < v) e.emplace_back(u, v);
+    return e;
+}
+
+static std::string text_request(const std::string& cmd, const Graph& G) {
+    std::string s = cmd + " FILE\n" + std::to_string(G.n()) + " " + std::to_string(G.m()) + "\n";
+    for (auto [u, v] : edge_list(G)) {
+        s += std::to_string(u);
+        s += ' ';
+        s += std::to_string(v);
+        s += '\n';
+    }
+    return s + "END\n";
+}
+
+static std::string binary_request(const std::string& cmd, const Graph& G) {
+    std::string s = cmd + " BIN\n";
+    std::size_t at = s.size();
+    s.resize(at + kFrameHeaderBytes + kGraphHeaderBytes + 8 * G.m());
+    char* p = &s[at];
+    const std::uint64_t bytes = kGraphHeaderBytes + 8 * static_cast<std::uint64_t>(G.m());
+    store_u32(p, kFrameGraph);
+    store_u32(p + 4, static_cast<std::uint32_t>(bytes));
+    store_u32(p + 8, static_cast<std::uint32_t>(bytes >> 32));
+    store_u32(p + 12, static_cast<std::uint32_t>(G.n()));
+    store_u32(p + 16, static_cast<std::uint32_t>(G.m()));
+    p += kFrameHeaderBytes + kGraphHeaderBytes;
+    for (auto [u, v] : edge_list(G)) {
+        store_u32(p, static_cast<std::uint32_t>(u));
+        store_u32(p + 4, static_cast<std::uint32_t>(v));
+        p += 8;
+    }
+    return s;
+}
+
+// "OK CIRCUIT m\nv0 v1 ...\nEND\n" -> vertices
+static bool parse_text_circuit(const std::string& r, std::vector<std::size_t>& tour) {
+    tour.clear();
+    std::size_t i = r.find('\n');
+    if (r.compare(0, 11, "OK CIRCUIT ") != 0 || i == std::string::npos) return false;
+    for (++i; i < r.size() && r[i] != '\n';) {
+        std::size_t v = 0;
+        while (i < r.size() && r[i] >= '0' && r[i] <= '9') v = v * 10 + static_cast<std::size_t>(r[i++] - '0');
+        tour.push_back(v);
+        if (i < r.size() && r[i] == ' ') ++i;
+    }
+    return r.compare(i, std::string::npos, "\nEND\n") == 0;
+}
+
+static bool parse_binary_circuit(const std::string& r, std::vector<std::size_t>& tour) {
+    tour.clear();
+    if (r.size() < kFrameHeaderBytes || load_u32(r.data()) != kFrameCircuit) return false;
+    if (load_u64(r.data() + 4) != r.size() - kFrameHeaderBytes) return false;
+    for (std::size_t i = kFrameHeaderBytes; i + 4 <= r.size(); i += 4) tour.push_back(load_u32(r.data() + i));
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const unsigned port = static_cast<unsigned>(arg_u64(argc, argv, "-p", 5555));
+    const std::size_t n = arg_u64(argc, argv, "-n", 100000);
+    const std::size_t m = arg_u64(argc, argv, "-m", 1000000);
+    const unsigned seed = static_cast<unsigned>(arg_u64(argc, argv, "-s", 1));
+    const int reps = static_cast<int>(arg_u64(argc, argv, "-r", 3));
+    const std::string alg = arg_str(argc, argv, "-a", "");
+    const std::string cmd = alg.empty() ? "EULER" : "ALG " + alg;
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    const Graph G = Graph::random_eulerian(n, m, seed);
+    std::printf("graph: n=%zu m=%zu, %s on port %u\n", G.n(), G.m(), cmd.c_str(), port);
+    std::printf("%-8s %12s %12s %10s  %s\n", "protocol", "sent MiB", "recv MiB", "best ms", "circuit");
+
+    auto report = [&](const char* name, const std::string& req, auto&& parse) {
+        std::string reply;
+        bool sent = true;
+        const double t = best_of(reps, [&] { sent = round_trip(addr, req, reply) && sent; });
+        std::vector<std::size_t> tour;
+        const bool valid = sent && parse(reply, tour) && is_euler_circuit(G, tour);
+        std::printf("%-8s %12.1f %12.1f %10.0f  %s\n", name, mib(req.size()), mib(reply.size()), t,
+                    valid ? "ok" : "INVALID");
+    };
+    report("text", text_request(cmd, G), parse_text_circuit);
+    report("binary", binary_request(cmd, G), parse_binary_circuit);
+    return 0;
+}
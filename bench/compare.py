@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""Compare two bench_suite JSON runs (make bench) case by case.
+
+Prints base and new time per case and the change, marks cases slower than
+--threshold (default 0.10: 10%) as REGRESSION, faster ones as faster, and
+cases whose result string differs as RESULT CHANGED. Cases whose base time
+is under --min-ms are shown but never flagged: they are mostly noise.
+Exit status is 1 if anything was flagged, so it can gate a build.
+
+    ./compare.py results/base.json results/new.json --threshold 0.05
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        run = json.load(f)
+    return run["context"], {b["name"]: b for b in run["benchmarks"]}
+
+
+def describe(ctx):
+    return "{} ({}, {}, {} cpus, {})".format(
+        ctx.get("label") or "unlabelled", ctx.get("date"), ctx.get("cpu"), ctx.get("num_cpus"), ctx.get("compiler"))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("base")
+    ap.add_argument("new")
+    ap.add_argument("--threshold", type=float, default=0.10, help="relative slowdown flagged (default 0.10)")
+    ap.add_argument("--metric", default="min_ms", choices=["min_ms", "median_ms", "mean_ms"],
+                    help="time compared (default min_ms, the least noisy)")
+    ap.add_argument("--min-ms", type=float, default=0.5, help="base times below this are not flagged")
+    args = ap.parse_args()
+
+    base_ctx, base = load(args.base)
+    new_ctx, new = load(args.new)
+    print("base:", describe(base_ctx))
+    print("new: ", describe(new_ctx))
+    for key in ("cpu", "num_cpus", "threads", "compiler", "optimized"):
+        if base_ctx.get(key) != new_ctx.get(key):
+            print("warning: {} differs ({} vs {})".format(key, base_ctx.get(key), new_ctx.get(key)))
+    print()
+
+    width = max([len(name) for name in base] + [4])
+    print("{:<{w}} {:>12} {:>12} {:>8}".format("case", "base ms", "new ms", "change", w=width))
+    regressions = changed = 0
+    for name, b in base.items():
+        n = new.get(name)
+        if n is None:
+            print("{:<{w}} {:>12.3f} {:>12} {:>8}  missing in new run".format(name, b[args.metric], "-", "", w=width))
+            continue
+        t0, t1 = b[args.metric], n[args.metric]
+        delta = (t1 - t0) / t0 if t0 > 0 else 0.0
+        notes = []
+        if t0 >= args.min_ms and delta > args.threshold:
+            notes.append("REGRESSION")
+            regressions += 1
+        elif t0 >= args.min_ms and delta < -args.threshold:
+            notes.append("faster")
+        if b.get("result") != n.get("result"):
+            notes.append("RESULT CHANGED: {!r} -> {!r}".format(b.get("result"), n.get("result")))
+            changed += 1
+        print("{:<{w}} {:>12.3f} {:>12.3f} {:>+7.1f}%  {}".format(name, t0, t1, 100 * delta, " ".join(notes),
+                                                                  w=width).rstrip())
+    for name in new:
+        if name not in base:
+            print("{:<{w}} {:>12} {:>12.3f} {:>8}  new case".format(name, "-", new[name][args.metric], "", w=width))
+
+    print("\n{} regression(s) beyond {:.0f}%, {} changed result(s)".format(regressions, 100 * args.threshold, changed))
+    return 1 if regressions or changed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
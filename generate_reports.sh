@@ -7,6 +7,9 @@ make
 
 mkdir -p reports
 
+# Profiles need a graph big enough to measure; g_ok6.txt finishes in microseconds
+PROFILE_ARGS=${PROFILE_ARGS:--n 100000 -m 1000000 -s 42 -e}
+
 echo "[A] Valgrind memcheck (file and random)"
 valgrind --leak-check=full --show-leak-kinds=all --track-origins=yes \
   ./bin/euler_app -i g_ok6.txt 2> reports/valgrind_memcheck_file.txt
@@ -18,14 +21,14 @@ valgrind --tool=helgrind ./bin/euler_app -i g_ok6.txt 2> reports/helgrind_file.t
 
 echo "[C] Callgrind (profiling call graph)"
 valgrind --tool=callgrind --callgrind-out-file=reports/callgrind.out.euler \
-  ./bin/euler_app -i g_ok6.txt
+  ./bin/euler_app $PROFILE_ARGS > /dev/null
 # Optional: kcachegrind reports/callgrind.out.euler
 
 echo "[D] gprof (rebuild with -pg)"
 make clean
 make CXXFLAGS="-std=gnu++17 -O2 -g -pg -Wall -Wextra -Wpedantic -Wconversion -Wshadow -Wnull-dereference -Wformat=2 -Wundef -Wpointer-arith -pthread" \
      LDFLAGS="-pg -pthread"
-./bin/euler_app -i g_ok6.txt > /dev/null
+./bin/euler_app $PROFILE_ARGS > /dev/null
 gprof ./bin/euler_app gmon.out > reports/gprof_report.txt
 
 echo "[E] Coverage (rebuild with gcov/lcov flags)"
@@ -0,0 +1,153 @@
+// Replies of the registered algorithms on small edge cases, through the
+// same registry lookup the server uses, and how results pass through the
+// result cache. Exits non-zero if any check fails.
+//
+//   make test        (from Stage7)
+
+#include "algorithms.hpp"
+#include "result_cache.hpp"
+#include "server_protocol.hpp"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+    if (ok) return;
+    std::fprintf(stderr, "FAIL %s\n", what.c_str());
+    ++failures;
+}
+
+Graph make_graph(std::size_t n, const std::vector<std::pair<std::size_t, std::size_t>>& edges) {
+    Graph g(n);
+    for (const auto& [u, v] : edges) g.add_edge(u, v);
+    g.finalize();
+    return g;
+}
+
+// The reply 'spec' writes for 'g', without the trailing END.
+std::string reply(const char* spec, const Graph& g) {
+    AlgorithmArgs args;
+    const GraphAlgorithm* alg = find_algorithm(spec, args);
+    if (!alg) return "unknown algorithm";
+    std::string out;
+    alg->append(AlgorithmCall{g, args, nullptr}, out);
+    return out;
+}
+
+void expect(const char* spec, const Graph& g, const std::string& want, const char* what) {
+    const std::string got = reply(spec, g);
+    check(got == want, std::string(what) + ": got \"" + got + "\", want \"" + want + "\"");
+}
+
+// 'spec' on 'g' through cache.write_through() into a string-backed writer,
+// the way the server answers a cacheable ALG request; "pre" is already
+// buffered and must not end up in the cached copy.
+std::string write_through(ResultCache& cache, const char* spec, const std::string& key, const Graph& g) {
+    AlgorithmArgs args;
+    const GraphAlgorithm* alg = find_algorithm(spec, args);
+    std::string sent;
+    {
+        FdWriter out(sent);
+        out.put("pre ");
+        cache.write_through(spec, key, out, [&](FdWriter& w) {
+            alg->write(AlgorithmCall{g, args, nullptr}, w);
+            return true;
+        });
+    }
+    return sent;
+}
+
+// EULER on 'g' through cache.write_through() to a socket whose peer has
+// closed, with the lambda of euler_server (Stage6) or of alg_server's
+// execute_request: the send fails part way, so nothing may be kept.
+void write_to_closed_peer(ResultCache& cache, const std::string& key, const Graph& g, bool euler_server) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+        check(false, "socketpair");
+        return;
+    }
+    ::close(sv[1]);
+    {
+        FdWriter out(sv[0], /*socket=*/true);
+        AlgorithmArgs args;
+        const GraphAlgorithm* alg = find_algorithm("EULER", args);
+        if (euler_server) {
+            cache.write_through("EULER", key, out, [&](FdWriter& w) {
+                w.put("OK CIRCUIT ");
+                w.put_uint(g.m());
+                w.put('\n');
+                const bool done = write_circuit(w, g);
+                w.put("\nEND\n");
+                return done && w.ok();
+            });
+        } else {
+            cache.write_through("EULER", key, out, [&](FdWriter& w) {
+                alg->write(AlgorithmCall{g, args, nullptr}, w);
+                return w.ok();
+            });
+        }
+        check(!out.ok(), key + ": send to a closed peer succeeded");
+    }
+    ::close(sv[0]);
+}
+
+Graph cycle(std::size_t n) {
+    Graph g(n);
+    for (std::size_t u = 0; u < n; ++u) g.add_edge(u, (u + 1) % n);
+    g.finalize();
+    return g;
+}
+
+} // namespace
+
+int main() {
+    // A cycle needs three distinct vertices: with n <= 2 there is none, not
+    // even the walk 0 1 0 over a single edge
+    const std::string none = "ERR No Hamiltonian cycle";
+    expect("HAMILTON", make_graph(0, {}), none, "HAMILTON n=0");
+    expect("HAMILTON", make_graph(1, {}), none, "HAMILTON n=1");
+    expect("HAMILTON", make_graph(2, {}), none, "HAMILTON n=2 without edges");
+    expect("HAMILTON", make_graph(2, {{0, 1}}), none, "HAMILTON n=2 with one edge");
+
+    const std::string triangle = reply("HAMILTON", make_graph(3, {{0, 1}, {1, 2}, {2, 0}}));
+    check(triangle == "OK HAMILTON 0 1 2 0" || triangle == "OK HAMILTON 0 2 1 0", "HAMILTON triangle: " + triangle);
+    expect("HAMILTON", make_graph(4, {{0, 1}, {1, 2}, {2, 3}}), none, "HAMILTON path");
+
+    // A cached result is still streamed: one over the entry limit is sent
+    // whole but not kept, a small one is sent and kept
+    ResultCache cache(1 << 20);
+    const Graph big = cycle(100000), small = cycle(5);
+    const std::string big_reply = reply("EULER", big), small_reply = reply("EULER", small);
+    check(big_reply.size() > cache.entry_limit(), "EULER on the big cycle fits the entry limit");
+    check(write_through(cache, "EULER", "big", big) == "pre " + big_reply, "streamed big EULER differs");
+    check(!cache.get("EULER", "big"), "big EULER result was cached");
+    check(write_through(cache, "EULER", "small", small) == "pre " + small_reply, "streamed small EULER differs");
+    const auto kept = cache.get("EULER", "small");
+    check(kept && *kept == small_reply, "small EULER result was not cached as sent");
+    check(cache.stats().entries == 1, "cache holds other entries than the small result");
+
+    // A result cut short by a failed send is not kept, however small the
+    // part that was written
+    ResultCache roomy(std::size_t{64} << 20);
+    check(big_reply.size() < roomy.entry_limit(), "EULER on the big cycle exceeds the roomy entry limit");
+    write_to_closed_peer(roomy, "euler_server", big, true);
+    check(!roomy.get("EULER", "euler_server"), "euler_server kept a circuit cut short by a failed send");
+    write_to_closed_peer(roomy, "alg_server", big, false);
+    check(!roomy.get("EULER", "alg_server"), "alg_server kept a result cut short by a failed send");
+
+    if (failures) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("test_algorithms: all checks passed\n");
+    return 0;
+}
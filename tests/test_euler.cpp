@@ -0,0 +1,61 @@
+// Regression test for the Euler circuit builders: on seeded random Eulerian
+// graphs, the serial, parallel and streamed circuits must each use every
+// edge exactly once and close up. Exits non-zero if any check fails.
+//
+//   make test        (from Stage4, or a subdirectory for the root makefile)
+
+#include "graph.hpp"
+#include "euler.hpp"
+#include "bench_graphs.hpp"
+
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what, std::size_t n, std::size_t m, unsigned seed) {
+    if (ok) return;
+    std::fprintf(stderr, "FAIL %s (n=%zu m=%zu seed=%u)\n", what, n, m, seed);
+    ++failures;
+}
+
+void test_graph(std::size_t n, std::size_t m, unsigned seed) {
+    const Graph g = Graph::random_eulerian(n, m, seed);
+    check(euler_feasibility(g).ok, "feasibility", n, m, seed);
+    check(is_euler_circuit(g, find_euler_circuit(g)), "serial circuit", n, m, seed);
+    for (unsigned threads : {2u, 4u, 8u})
+        check(is_euler_circuit(g, find_euler_circuit_parallel(g, threads)), "parallel circuit", n, m, seed);
+
+    std::vector<std::size_t> streamed;
+    const bool done = stream_euler_circuit(g, [&](const std::size_t* v, std::size_t count) {
+        streamed.insert(streamed.end(), v, v + count);
+        return true;
+    });
+    check(done && is_euler_circuit(g, streamed), "streamed circuit", n, m, seed);
+}
+
+} // namespace
+
+int main() {
+    // Small graphs hit the edge cases (few vertices, m barely above n),
+    // the large ones the O(n + m) walk and the parallel splicing.
+    for (unsigned seed = 1; seed <= 20; ++seed) test_graph(8, 12, seed);
+    for (unsigned seed = 1; seed <= 5; ++seed) test_graph(1000, 5000, seed);
+    for (unsigned seed = 1; seed <= 2; ++seed) test_graph(100000, 500000, seed);
+
+    // A graph with odd-degree vertices has no circuit
+    Graph odd(4);
+    odd.add_edge(0, 1);
+    odd.add_edge(1, 2);
+    odd.finalize();
+    check(!euler_feasibility(odd).ok && find_euler_circuit(odd).empty(), "odd degrees rejected", 4, 2, 0);
+
+    if (failures) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("test_euler: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,118 @@
+// Tests for RequestWatcher on loopback TCP connections: a client that
+// half-closes (shutdown(SHUT_WR)) well after its request still gets its
+// reply, a reset cancels with Disconnected, and a deadline with Timeout.
+// Exits non-zero if any check fails.
+//
+//   make test        (from Stage7)
+
+#include "request_watcher.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+    if (ok) return;
+    std::fprintf(stderr, "FAIL %s\n", what);
+    ++failures;
+}
+
+// A connected loopback pair: {client, server}.
+std::pair<int, int> connect_pair() {
+    const int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (listener < 0 || ::bind(listener, (sockaddr*)&addr, sizeof(addr)) < 0 || ::listen(listener, 1) < 0 ||
+        ::getsockname(listener, (sockaddr*)&addr, &len) < 0) {
+        std::perror("listen");
+        std::exit(1);
+    }
+    const int client = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (client < 0 || ::connect(client, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        std::perror("connect");
+        std::exit(1);
+    }
+    const int server = ::accept(listener, nullptr, nullptr);
+    ::close(listener);
+    return {client, server};
+}
+
+// Wait up to a second for 'token' to fire.
+bool wait_cancelled(const CancelToken* token) {
+    for (int i = 0; i < 100 && !cancelled(token); ++i) std::this_thread::sleep_for(10ms);
+    return cancelled(token);
+}
+
+void test_late_half_close(RequestWatcher& watcher) {
+    auto [client, server] = connect_pair();
+    RequestWatcher::Watch w = watcher.watch(server, std::nullopt);
+    // Well after the request, as a slow client would
+    std::this_thread::sleep_for(200ms);
+    ::shutdown(client, SHUT_WR);
+    std::this_thread::sleep_for(200ms);
+    check(!cancelled(w.token()), "half-close does not cancel");
+
+    const std::string reply = "OK CIRCUIT 3\n0 1 2 0\nEND\n";
+    check(::send(server, reply.data(), reply.size(), MSG_NOSIGNAL) == (ssize_t)reply.size(), "reply sent");
+    w.reset();
+    ::close(server);
+    std::string got;
+    char buf[256];
+    for (ssize_t r; (r = ::recv(client, buf, sizeof(buf), 0)) > 0;) got.append(buf, (size_t)r);
+    check(got == reply, "half-closed client reads the reply");
+    ::close(client);
+}
+
+void test_reset(RequestWatcher& watcher) {
+    auto [client, server] = connect_pair();
+    RequestWatcher::Watch w = watcher.watch(server, std::nullopt);
+    linger hard{1, 0}; // close() sends RST
+    ::setsockopt(client, SOL_SOCKET, SO_LINGER, &hard, sizeof(hard));
+    ::close(client);
+    check(wait_cancelled(w.token()) && w.token()->reason() == CancelToken::Reason::Disconnected,
+          "reset cancels as Disconnected");
+    w.reset();
+    ::close(server);
+}
+
+void test_timeout(RequestWatcher& watcher) {
+    auto [client, server] = connect_pair();
+    RequestWatcher::Watch w = watcher.watch(server, 50ms);
+    check(wait_cancelled(w.token()) && w.token()->reason() == CancelToken::Reason::Timeout,
+          "deadline cancels as Timeout");
+    w.reset();
+    ::close(server);
+    ::close(client);
+}
+
+} // namespace
+
+int main() {
+    RequestWatcher watcher;
+    test_late_half_close(watcher);
+    test_reset(watcher);
+    test_timeout(watcher);
+
+    if (failures) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("test_request_watcher: all checks passed\n");
+    return 0;
+}